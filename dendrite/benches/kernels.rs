@@ -0,0 +1,161 @@
+//! Microbenchmarks for hot kernels. 
+//!
+//! Run with `cargo bench --bench kernels [<filter>]`. Each benchmark is run
+//! on synthetic inputs built with [TraceAssembler], so results are 
+//! comparable between runs. 
+
+use dendrite::*;
+use dendrite::trace::assembler::*;
+use std::hint::black_box;
+use std::time::{ Duration, Instant };
+
+/// Minimum amount of time spent measuring each benchmark
+const MEASURE_TIME: Duration = Duration::from_millis(500);
+
+struct Bench {
+    filter: Option<String>,
+}
+impl Bench {
+    /// Run 'f' repeatedly and print the average time per iteration.
+    /// Each iteration processes 'elems' elements. 
+    fn run(&self, name: &str, elems: usize, mut f: impl FnMut()) {
+        if let Some(filter) = self.filter.as_ref() {
+            if !name.contains(filter.as_str()) {
+                return;
+            }
+        }
+
+        // Warm up, and estimate the number of iterations to measure
+        let start = Instant::now();
+        let mut iters = 0;
+        while start.elapsed() < MEASURE_TIME / 10 {
+            f();
+            iters += 1;
+        }
+        let iters = (iters * 10).max(1);
+
+        let start = Instant::now();
+        for _ in 0..iters {
+            f();
+        }
+        let elapsed = start.elapsed();
+        let per_iter = elapsed.as_nanos() as f64 / iters as f64;
+        let per_elem = per_iter / elems as f64;
+        let melems = elems as f64 * iters as f64 / elapsed.as_secs_f64() / 1e6;
+        println!("{:40} {:12.1} ns/iter {:9.3} ns/elem {:10.2} Melem/s", 
+            name, per_iter, per_elem, melems);
+    }
+}
+
+fn main() {
+    let filter = std::env::args().skip(1).find(|a| !a.starts_with("--"));
+    let b = Bench { filter };
+
+    let trace = synthetic_loop(1 << 16);
+    let records = &trace.data;
+    let outcomes: Vec<Outcome> = records.iter().map(|r| r.outcome).collect();
+
+    // History registers
+    for len in [64, 128, 1024] {
+        let mut ghr = HistoryRegister::new(len);
+        b.run(&format!("history/shift_by/{}", len), 1, || {
+            ghr.shift_by(1);
+            black_box(&ghr);
+        });
+        b.run(&format!("history/fold/{}to12", len), 1, || {
+            black_box(ghr.fold(0..=len-1, 12));
+        });
+        let mut csr = FoldedHistoryRegister::new(12, 0..=len-1);
+        b.run(&format!("history/folded_update/{}", len), 1, || {
+            csr.update(black_box(&ghr));
+        });
+    }
+
+    // Counters
+    let mut ctr = SaturatingCounterConfig {
+        max_t_state: 2, max_n_state: 2, default_state: Outcome::N
+    }.build();
+    b.run("counter/update", outcomes.len(), || {
+        for o in outcomes.iter() {
+            ctr.update(*o);
+        }
+        black_box(&ctr);
+    });
+
+    // Perceptron training
+    for len in [16, 32, 64] {
+        let mut ghr = HistoryRegister::new(len);
+        let inputs: Vec<Vec<i8>> = outcomes.iter().take(4096).map(|o| {
+            ghr.shift_by(1);
+            ghr.data_mut().set(0, (*o).into());
+            ghr.data().iter().by_vals().map(|b| if b { 1 } else { -1 })
+                .collect()
+        }).collect();
+        match len {
+            16 => bench_perceptron::<16>(&b, &inputs, &outcomes),
+            32 => bench_perceptron::<32>(&b, &inputs, &outcomes),
+            64 => bench_perceptron::<64>(&b, &inputs, &outcomes),
+            _ => unreachable!(),
+        }
+    }
+
+    // TAGE prediction and update
+    let mut tage = TAGEConfig::preset_default().build();
+    let mut hist = EvalHistory::new();
+    b.run("tage/predict", records.len(), || {
+        for record in records.iter() {
+            if record.is_conditional() {
+                let inputs = TAGEInputs { pc: record.pc, phr: &hist.phr };
+                black_box(tage.predict(inputs));
+            }
+            hist.update(record);
+            tage.update_history(&hist.ghr);
+        }
+    });
+    b.run("tage/predict_update", records.len(), || {
+        for record in records.iter() {
+            if record.is_conditional() {
+                let inputs = TAGEInputs { pc: record.pc, phr: &hist.phr };
+                let p = tage.predict(inputs.clone());
+                tage.update(inputs, p, record.outcome);
+            }
+            hist.update(record);
+            tage.update_history(&hist.ghr);
+        }
+    });
+
+    // Statistics
+    b.run("stats/update_per_branch", records.len(), || {
+        let mut stats = BranchStats::new();
+        for record in records.iter() {
+            stats.update_per_branch(record, record.outcome);
+        }
+        black_box(&stats);
+    });
+
+    // Loading a trace from disk
+    let path = std::env::temp_dir().join("dendrite-bench.trace");
+    let bytes = unsafe {
+        std::slice::from_raw_parts(records.as_ptr() as *const u8,
+            records.len() * std::mem::size_of::<BranchRecord>())
+    };
+    std::fs::write(&path, bytes).unwrap();
+    let path = path.to_str().unwrap();
+    b.run("trace/from_file", records.len(), || {
+        black_box(BinaryTrace::from_file(path, ""));
+    });
+    std::fs::remove_file(path).unwrap();
+}
+
+fn bench_perceptron<const L: usize>(b: &Bench, inputs: &[Vec<i8>], 
+    outcomes: &[Outcome]) 
+{
+    let mut p = Perceptron::<L>::new();
+    b.run(&format!("perceptron/train/{}", L), inputs.len(), || {
+        for (input, o) in inputs.iter().zip(outcomes.iter()) {
+            p.train(input, *o);
+        }
+        black_box(&p);
+    });
+}
+
@@ -0,0 +1,52 @@
+//! Helpers for parsing command-line options in the binaries.
+//!
+//! Bad options are reported with [usage_error] [a message and a non-zero
+//! exit status] instead of a panic.
+
+use std::str::FromStr;
+
+/// Print an error about the command-line options and exit.
+pub fn usage_error(msg: impl std::fmt::Display) -> ! {
+    println!("[!] {}", msg);
+    std::process::exit(1);
+}
+
+/// Parse the value for some option, or exit with a usage error.
+pub fn parse_value<T: FromStr>(opt: &str, val: Option<&String>) -> T {
+    match val.and_then(|s| s.parse().ok()) {
+        Some(x) => x,
+        None => usage_error(format!("{} requires a valid value", opt)),
+    }
+}
+
+/// Parse the value for an option that must be a positive integer, or exit
+/// with a usage error.
+pub fn parse_nonzero(opt: &str, val: Option<&String>) -> usize {
+    match val.and_then(|s| s.parse().ok()) {
+        Some(n) if n != 0 => n,
+        _ => usage_error(format!("{} requires a positive integer", opt)),
+    }
+}
+
+/// Return the value for an option that takes a path, or exit with a usage
+/// error.
+pub fn parse_path(opt: &str, val: Option<&String>) -> String {
+    match val {
+        Some(s) => s.clone(),
+        None => usage_error(format!("{} requires a file", opt)),
+    }
+}
+
+/// Exit with a usage error if some argument looks like an unknown option
+/// [otherwise it would be treated as a predictor or trace].
+pub fn check_unknown_option(arg: &str) {
+    if arg.starts_with("--") {
+        usage_error(format!("unknown option {}", arg));
+    }
+}
+
+/// Parse a list of predictor specifications, or exit with a usage error.
+pub fn parse_specs(list: &[String]) -> Vec<crate::eval::PredictorSpec> {
+    crate::eval::PredictorSpec::parse_list(list)
+        .unwrap_or_else(|e| usage_error(e))
+}
@@ -0,0 +1,54 @@
+
+use dendrite::*;
+use std::env;
+use std::time::Instant;
+
+fn main() {
+    let args: Vec<String> = env::args().collect();
+    if args.len() < 2 {
+        println!("usage: {} <trace file> [<number of branches>]", args[0]);
+        return;
+    }
+    let num_branches = if args.len() > 2 {
+        args[2].parse().unwrap()
+    } else {
+        32
+    };
+
+    let trace = BinaryTrace::from_file(&args[1], "");
+    let trace_records = trace.as_slice();
+    println!("[*] Loaded {} records from {}", trace.num_entries(), args[1]);
+
+    let mut analyzer = EntropyConfig {
+        lengths: vec![0, 1, 2, 4, 8, 16, 32, 64],
+        table_bits: 22,
+        local_bits: 14,
+    }.build();
+
+    let start = Instant::now();
+    for record in trace_records {
+        analyzer.update(record);
+    }
+    println!("[*] Completed in {:.3?}", start.elapsed());
+    println!("[*] Unique branches: {}", analyzer.data.len());
+
+    // Print the estimated entropy (bits per outcome) for each history length
+    let lengths = analyzer.lengths().to_vec();
+    let header: String = lengths.iter()
+        .map(|len| format!(" {:>6}", format!("k={}", len)))
+        .collect();
+    println!("[*] Conditional entropy for the {} most common branches:", 
+        num_branches);
+    println!("    {:16} {:>10} {:>6} {:6}{}", "pc", "occ", "bias", "", header);
+    for (pc, data) in analyzer.get_hot_branches(num_branches) {
+        let g: String = (0..lengths.len())
+            .map(|idx| format!(" {:6.3}", data.global_entropy(idx)))
+            .collect();
+        let l: String = (0..lengths.len())
+            .map(|idx| format!(" {:6.3}", data.local_entropy(idx)))
+            .collect();
+        println!("    {:016x} {:10} {:6.3} global{}", 
+            pc, data.occ, data.bias_entropy(), g);
+        println!("    {:16} {:10} {:6} local {}", "", "", "", l);
+    }
+}
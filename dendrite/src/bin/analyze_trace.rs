@@ -6,7 +6,7 @@ use std::collections::*;
 use bitvec::prelude::*;
 
 /// For classifying different patterns of conditional branch outcomes. 
-#[derive(Clone, Debug, PartialEq, Eq, Hash)]
+#[derive(Clone, Debug, PartialEq, Eq, PartialOrd, Ord, Hash)]
 enum BranchPattern {
     /// A branch with an unknown/uncomputed pattern.
     Unknown,
@@ -27,6 +27,39 @@ enum BranchPattern {
 
 }
 impl BranchPattern {
+    /// Find the shortest sequence [of at least two runs] which repeats 
+    /// more than once to form the entire list of runs.
+    ///
+    /// Uses the prefix function, which gives the smallest period 'p' of the
+    /// list in linear time. The list is only made of whole repetitions if 
+    /// 'p' divides the length of the list, and then every such repeating 
+    /// sequence has a length that is some multiple of 'p'.
+    fn repeat_len(rle: &[usize]) -> Option<usize> {
+        let n = rle.len();
+        let mut pi = vec![0; n];
+        for i in 1..n {
+            let mut k = pi[i - 1];
+            while k > 0 && rle[i] != rle[k] {
+                k = pi[k - 1];
+            }
+            if rle[i] == rle[k] {
+                k += 1;
+            }
+            pi[i] = k;
+        }
+        let period = n - pi[n - 1];
+        if n % period != 0 {
+            return None;
+        }
+        // When all runs are the same length, use the smallest divisor
+        let len = if period == 1 {
+            (2..=n / 2).find(|d| n % d == 0)?
+        } else {
+            period
+        };
+        if len < n { Some(len) } else { None }
+    }
+
     pub fn from_bitvec(bits: &BitVec) -> Self { 
         let initial_outcome = bits[0];
 
@@ -78,29 +111,17 @@ impl BranchPattern {
 
 
         // A repeating pattern of runs. 
-        for pattern_len in 2..=(bits.len() / 2) {
-            let mut iter = rle.chunks(pattern_len);
-            let num_iters = iter.len();
-            let first = iter.next().unwrap();
-            if iter.len() == 0 {
-                continue; 
+        if let Some(pattern_len) = Self::repeat_len(&rle) {
+            let num_iters = rle.len() / pattern_len;
+            let first = &rle[0..pattern_len];
+            let initial: Outcome = initial_outcome.into();
+            let mut pattern = Vec::new();
+            let mut o = initial;
+            for run in first { 
+                pattern.push((o, *run));
+                o = !o;
             }
-            if iter.all(|e| e == first) {
-                let initial: Outcome = initial_outcome.into();
-                let mut pattern = Vec::new();
-                let mut o = initial;
-                for run in first { 
-                    pattern.push((o, *run));
-                    o = !o;
-                }
-                return BranchPattern::GlobalPattern(num_iters, pattern);
-            }
-        }
-
-        println!("{:?}", rle);
-        let iter = rle.chunks(2);
-        for c in iter {
-            println!("{:?}", c);
+            return BranchPattern::GlobalPattern(num_iters, pattern);
         }
 
         //println!("{:?}", rle);
@@ -113,9 +134,19 @@ impl BranchPattern {
 fn main() {
     let args: Vec<String> = env::args().collect();
     if args.len() < 2 {
-        println!("usage: {} <trace file>", args[0]);
+        println!("usage: {} <trace file> [--threads <n>]", args[0]);
         return;
     }
+    let mut pool = WorkPool::with_available_parallelism();
+    let mut opts = args[2..].iter();
+    while let Some(opt) = opts.next() {
+        match opt.as_str() {
+            "--threads" => {
+                pool = WorkPool::new(parse_nonzero(opt, opts.next()));
+            },
+            _ => usage_error(format!("unknown option {}", opt)),
+        }
+    }
 
     let trace = BinaryTrace::from_file(&args[1], "");
     let trace_records = trace.as_slice();
@@ -128,18 +159,22 @@ fn main() {
     }
 
     println!("[*] Found {} unique branches", stat.num_unique_branches());
-    let mut pats = HashMap::new();
-
-    for (pc, brn) in stat.data.iter().sorted_by(|x, y| {
-        x.1.pat.len().partial_cmp(&y.1.pat.len()).unwrap()
-    }).rev()
-    {
-        // Ignore branches that are encountered only once
-        if brn.pat.len() == 1 { 
-            continue; 
-        }
 
-        let pat = BranchPattern::from_bitvec(&brn.pat);
+    // Ignore branches that are encountered only once
+    let brns: Vec<(&usize, &BranchData)> = stat.data.iter()
+        .filter(|(_, brn)| brn.pat.len() != 1)
+        .sorted_by(|x, y| {
+            x.1.pat.len().partial_cmp(&y.1.pat.len()).unwrap()
+        }).rev()
+        .collect();
+
+    // Classify each branch in parallel
+    let classes = pool.map(brns.clone(), |_, (_, brn)| {
+        BranchPattern::from_bitvec(&brn.pat)
+    });
+
+    let mut pats = BTreeMap::new();
+    for ((pc, brn), pat) in brns.iter().zip(classes.iter()) {
         let e = pats.entry(pat.clone()).or_insert(0);
         *e += 1;
 
@@ -156,11 +191,10 @@ fn main() {
 
     }
 
-    let iter = pats.iter().sorted_by(|x, y| x.1.partial_cmp(y.1).unwrap()).rev();
+    // Sort by the number of branches, then by pattern
+    let iter = pats.iter().sorted_by(|x, y| y.1.cmp(x.1).then(x.0.cmp(y.0)));
     for (pattern, cnt) in iter { 
         println!("occ={:8} {:?}", cnt, pattern);
     }
 
-
-
 }
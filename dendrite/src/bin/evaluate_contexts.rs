@@ -0,0 +1,98 @@
+
+use dendrite::*;
+use std::env;
+use std::time::Instant;
+
+fn main() {
+    let args: Vec<String> = env::args().collect();
+    if args.len() < 3 {
+        println!("usage: {} <predictor> <trace file>... [--mode <mode>] \
+            [--quantum <n>] [--baseline]", args[0]);
+        println!("  --mode      shared, flush, partition, or tag \
+            (default: shared)");
+        println!("  --quantum   records evaluated before switching contexts \
+            (default: 100000)");
+        println!("  --baseline  also run each trace alone with a private \
+            predictor, and report the difference");
+        return;
+    }
+
+    let spec = PredictorSpec::parse(&args[1])
+        .unwrap_or_else(|e| usage_error(e));
+    let mut mode = ContextMode::Shared;
+    let mut quantum = 100_000;
+    let mut baseline = false;
+    let mut files = Vec::new();
+    let mut opts = args[2..].iter();
+    while let Some(opt) = opts.next() {
+        match opt.as_str() {
+            "--mode" => {
+                let name: String = parse_value(opt, opts.next());
+                mode = ContextMode::parse(&name)
+                    .unwrap_or_else(|e| usage_error(e));
+            },
+            "--quantum" => quantum = parse_nonzero(opt, opts.next()),
+            "--baseline" => baseline = true,
+            _ => {
+                check_unknown_option(opt);
+                files.push(opt.clone());
+            },
+        }
+    }
+    if files.is_empty() {
+        usage_error("no trace files");
+    }
+
+    let mut perf = PerfSummary::new("evaluate_contexts");
+    let traces: Vec<BinaryTrace> = perf.time(Phase::Load, || {
+        files.iter().map(|f| BinaryTrace::from_file(f, "")).collect()
+    });
+    let slices: Vec<&[BranchRecord]> = traces.iter()
+        .map(|t| t.as_slice())
+        .collect();
+    for (file, trace) in files.iter().zip(traces.iter()) {
+        println!("[*] Loaded {} records from {}", trace.num_entries(), file);
+    }
+
+    let mut eval = match ContextEvaluator::new(spec.clone(), mode, quantum, 
+        slices.len())
+    {
+        Ok(eval) => eval,
+        Err(e) => {
+            println!("[!] {}", e);
+            std::process::exit(1);
+        },
+    };
+    let start = Instant::now();
+    eval.run(&slices);
+    perf.add(Phase::Eval, start.elapsed());
+    println!("[*] Completed in {:.3?} ({} contexts, {:?}, {} switches)", 
+        start.elapsed(), slices.len(), mode, eval.num_switches);
+
+    let alone: Vec<Option<f64>> = slices.iter().map(|records| {
+        if !baseline {
+            return None;
+        }
+        let mut eval = MultiEvaluator::from_specs(&[spec.clone()]);
+        eval.run(records);
+        Some(mpkb(&eval.slots[0].stats))
+    }).collect();
+
+    for (ctx, stats) in eval.stats.iter().enumerate() {
+        print!("  [{}] {:32} {:.2}% correct, {:.3} MPKB", ctx, files[ctx],
+            stats.hit_rate() * 100.0, mpkb(stats));
+        match alone[ctx] {
+            Some(m) => println!(" (alone: {:.3}, {:+.3})", m, mpkb(stats) - m),
+            None => println!(),
+        }
+    }
+    let total = BranchStats::merge_all(eval.stats.iter()).unwrap();
+    println!("  Total: {:.2}% correct, {:.3} MPKB", 
+        total.hit_rate() * 100.0, mpkb(&total));
+    perf.set_counts(slices.iter().map(|s| s.len()).sum(), total.global_brns());
+    println!("{}", perf.summary());
+}
+
+fn mpkb(stats: &BranchStats) -> f64 {
+    stats.global_miss() as f64 * 1000.0 / stats.global_brns() as f64
+}
@@ -0,0 +1,52 @@
+
+use dendrite::*;
+use std::env;
+
+fn main() {
+    let args: Vec<String> = env::args().collect();
+    if args.len() < 2 {
+        println!("usage: {} <trace file> [--limit <n>] [--seed <n>]", args[0]);
+        println!("  Compares TAGE with reference folded history (recomputed \
+            with HistoryRegister::fold) against FoldedHistoryRegister.");
+        return;
+    }
+
+    let mut limit = usize::MAX;
+    let mut seed = 1;
+    let mut opts = args[2..].iter();
+    while let Some(opt) = opts.next() {
+        match opt.as_str() {
+            "--limit" => limit = opts.next().unwrap().parse().unwrap(),
+            "--seed" => seed = opts.next().unwrap().parse().unwrap(),
+            _ => panic!("unknown option {}", opt),
+        }
+    }
+
+    let mut perf = PerfSummary::new("evaluate_diff");
+    let trace = perf.time(Phase::Load, || BinaryTrace::from_file(&args[1], ""));
+    let trace_records = trace.as_slice_trunc(limit);
+    println!("[*] Loaded {} records from {}", trace_records.len(), args[1]);
+
+    // Allocation must be deterministic for both predictors to agree
+    let mut cfg = TAGEConfig::preset_default();
+    cfg.alloc_seed = Some(seed);
+    let mut eval = LockstepEvaluator::new(
+        ReferenceTAGE(cfg.clone().build()),
+        cfg.build(),
+        diff_tage_folded_history,
+    );
+    let res = perf.time(Phase::Eval, || eval.run(trace_records));
+    let num_conditional = trace_records[..eval.pos].iter()
+        .filter(|r| r.is_conditional())
+        .count();
+    perf.set_counts(eval.pos, num_conditional);
+    match res {
+        Ok(()) => println!("[*] No divergence after {} records", eval.pos),
+        Err(d) => {
+            println!("[!] {}", d);
+            println!("{}", perf.summary());
+            std::process::exit(1);
+        },
+    }
+    println!("{}", perf.summary());
+}
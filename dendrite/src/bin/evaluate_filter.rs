@@ -0,0 +1,107 @@
+
+use dendrite::*;
+use std::env;
+use std::time::{ Duration, Instant };
+
+/// Evaluate a predictor on a trace, returning the statistics and the time
+/// spent in the evaluation loop.
+fn run<P: EvalPredictor + ?Sized>(predictor: &mut P, records: &[BranchRecord])
+    -> (BranchStats, Duration)
+{
+    let mut hist = EvalHistory::new();
+    let mut stats = BranchStats::new();
+    let start = Instant::now();
+    for record in records {
+        if record.is_conditional() {
+            let (outcome, _) = predictor.step(record, &hist);
+            stats.update_global(record, outcome);
+        }
+        hist.update(record);
+        predictor.update_history(&hist);
+    }
+    (stats, start.elapsed())
+}
+
+fn mpkb(stats: &BranchStats) -> f64 {
+    stats.global_miss() as f64 * 1000.0 / stats.global_brns().max(1) as f64
+}
+
+fn main() {
+    let args: Vec<String> = env::args().collect();
+    if args.len() < 4 {
+        println!("usage: {} <trace file> <filter> <predictor>...", args[0]);
+        println!("  <filter>     bias:<n> or bloom:<n>[:<k>]");
+        println!("  <predictor>  see PredictorSpec (ie. tage, gshare:14)");
+        return;
+    }
+
+    let filter = FilterSpec::parse(&args[2]).unwrap();
+    let specs = PredictorSpec::parse_list(&args[3..]).unwrap();
+
+    let mut perf = PerfSummary::new("evaluate_filter");
+    let trace = perf.time(Phase::Load, || BinaryTrace::from_file(&args[1], ""));
+    let records = trace.as_slice();
+    println!("[*] Loaded {} records from {}", trace.num_entries(), args[1]);
+
+    // Find the branches that could be filtered by an ideal filter
+    let mut branches = BranchStats::new();
+    for record in records.iter().filter(|r| r.is_conditional()) {
+        branches.update_per_branch(record, record.outcome);
+    }
+    let always_taken = branches.num_always_taken();
+    let never_taken = branches.num_never_taken();
+    println!("[*] {} static branches ({} always taken, {} never taken)",
+        branches.num_unique_branches(), always_taken, never_taken);
+
+    for spec in specs.iter() {
+        let mut baseline = spec.build();
+        let (base_stats, base_time) = run(baseline.as_mut(), records);
+
+        let mut filtered = FilteredPredictor::new(filter.build(),
+            spec.build());
+        let (stats, time) = run(&mut filtered, records);
+        perf.add(Phase::Eval, base_time + time);
+
+        // Branches that never reached the underlying predictor after they
+        // were first observed
+        let kept_out = branches.data.keys()
+            .filter(|pc| filtered.is_filtered(**pc))
+            .count();
+
+        let stat = &filtered.stat;
+        println!("[*] {}+{}", filter, spec);
+        println!("    baseline: {:.3} MPKB in {:.3?}",
+            mpkb(&base_stats), base_time);
+        println!("    filtered: {:.3} MPKB in {:.3?} ({:.2}x)",
+            mpkb(&stats), time,
+            base_time.as_secs_f64() / time.as_secs_f64());
+        println!("    {}/{} dynamic branches predicted by the filter \
+            ({:.2}%), {} filter misses", stat.filtered,
+            stat.filtered + stat.forwarded, stat.filtered_rate() * 100.0,
+            stat.filtered_miss);
+        println!("    {}/{} static branches kept out of the predictor \
+            ({} ideal)", kept_out, branches.num_unique_branches(),
+            always_taken + never_taken);
+        // The first occurrence of each branch still reaches the predictor,
+        // so compare how much of its capacity was actually used
+        if let (Some(b), Some(f)) = (baseline.capacity(), filtered.capacity()) {
+            println!("    predictor entries used: {}/{} baseline, {}/{} \
+                filtered", b.used, b.entries, f.used, f.entries);
+            println!("    predictor allocations: {} baseline ({} failed), \
+                {} filtered ({} failed)", b.allocs, b.failed_allocs, 
+                f.allocs, f.failed_allocs);
+        }
+        println!("    filter storage: {}B", filtered.filter.heap_bytes());
+        if let BranchFilter::Bloom(f) = &filtered.filter {
+            let (n, t) = f.occupancy();
+            println!("    bloom occupancy: {:.2}% not-taken, {:.2}% taken",
+                n * 100.0, t * 100.0);
+        }
+    }
+    // Each predictor is run twice [with and without the filter]
+    let num_runs = 2 * specs.len();
+    let num_conditional = records.iter().filter(|r| r.is_conditional()).count();
+    perf.set_counts(records.len() * num_runs, num_conditional * num_runs);
+    println!("{}", perf.summary());
+}
+
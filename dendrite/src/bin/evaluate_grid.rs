@@ -0,0 +1,67 @@
+
+use dendrite::*;
+use std::env;
+use std::time::Instant;
+
+fn main() {
+    let args: Vec<String> = env::args().collect();
+    if args.len() < 4 {
+        println!("usage: {} <results file> <trace list> <predictor>... \
+            [--threads <n>] [--mem-mb <n>] [--per-branch] [--huge-pages]", 
+            args[0]);
+        return;
+    }
+
+    let mut pool = WorkPool::with_available_parallelism();
+    let mut mem_limit = 8 << 30;
+    let mut per_branch = false;
+    let mut spec_args = Vec::new();
+    let mut opts = args[3..].iter();
+    while let Some(opt) = opts.next() {
+        match opt.as_str() {
+            "--threads" => {
+                pool = WorkPool::new(parse_nonzero(opt, opts.next()));
+            },
+            "--mem-mb" => mem_limit = parse_nonzero(opt, opts.next()) << 20,
+            "--per-branch" => per_branch = true,
+            "--huge-pages" => set_huge_pages(true),
+            _ => {
+                check_unknown_option(opt);
+                spec_args.push(opt.clone());
+            },
+        }
+    }
+    let specs = parse_specs(&spec_args);
+
+    // The trace list has one path per line
+    let traces: Vec<String> = std::fs::read_to_string(&args[2]).unwrap()
+        .lines()
+        .map(|l| l.trim().to_string())
+        .filter(|l| !l.is_empty() && !l.starts_with('#'))
+        .collect();
+
+    let store = ResultStore::open(&args[1]).unwrap();
+    println!("[*] {} completed jobs in {}", store.num_completed(), args[1]);
+
+    let mut grid = GridEvaluator::new(pool, TraceCache::new(mem_limit), store);
+    grid.per_branch = per_branch;
+    let jobs = GridEvaluator::expand(&traces, &specs);
+    let num_jobs = jobs.len();
+
+    println!("[*] {} traces, {} predictors, {} threads", 
+        traces.len(), specs.len(), pool.num_threads());
+    let start = Instant::now();
+    let num_run = grid.run(jobs);
+    println!("[*] Ran {}/{} jobs in {:.3?}", num_run, num_jobs, start.elapsed());
+    if huge_pages_enabled() {
+        println!("[*] Huge pages: {}", HugePageReport::collect());
+    }
+    let failed = grid.store.failed();
+    if !failed.is_empty() {
+        println!("[!] {} jobs failed:", failed.len());
+        for (key, err) in failed.iter() {
+            println!("    {}: {}", key.replace('\t', " "), err);
+        }
+        std::process::exit(1);
+    }
+}
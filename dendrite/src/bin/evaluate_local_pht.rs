@@ -10,8 +10,7 @@ fn index_direct(pht: &SimplePHT, pc: usize) -> usize {
 }
 
 fn test_pht(pht_size: usize, records: &[BranchRecord]) -> BranchStats {
-    let mut stat = BranchStats::new();
-    let mut pht = SimplePHT::new(
+    let pht = SimplePHT::new(
         pht_size, 
         index_direct, 
         SaturatingCounterConfig { 
@@ -21,36 +20,12 @@ fn test_pht(pht_size: usize, records: &[BranchRecord]) -> BranchStats {
         },
     );
 
-    for record in records.iter().filter(|r| r.is_conditional()) {
-
-        // Use the program counter to get a PHT entry
-        let pht_idx = pht.get_index(record.pc);
-        let pht_entry = pht.get_entry_mut(pht_idx);
-
-        // Make a prediction
-        let prediction = pht_entry.predict();
-        let hit = prediction == record.outcome;
-
-        // Update global statistics
-        stat.global_brns += 1;
-        if hit {
-            stat.global_hits += 1;
-        }
-
-        // Update per-branch statistics
-        let brn_stat = stat.get_mut(record.pc);
-        brn_stat.pat.push(record.outcome.into());
-        brn_stat.occ += 1;
-        if hit { 
-            brn_stat.hits += 1;
-        }
-
-        // Update the PHT entry according to the outcome
-        pht_entry.update(record.outcome);
-
-    }
-
-    stat
+    // Use the program counter to get a PHT entry, and collect per-branch
+    // statistics for each prediction
+    let mut eval = Evaluator::new(pht);
+    eval.per_branch = true;
+    eval.run(records);
+    eval.stats
 }
 
 
@@ -58,15 +33,46 @@ fn test_pht(pht_size: usize, records: &[BranchRecord]) -> BranchStats {
 fn main() {
     let args: Vec<String> = env::args().collect();
     if args.len() < 2 {
-        println!("usage: {} <trace file>", args[0]);
+        println!("usage: {} [--export <file>] <trace file>...", args[0]);
         return;
     }
 
-    let traces = BinaryTraceSet::new_from_slice(&args[1..]);
-    for trace in traces {
+    // Optionally append per-branch results for each trace to a file
+    let mut writer = None;
+    let mut files = Vec::new();
+    let mut opts = args[1..].iter();
+    while let Some(opt) = opts.next() {
+        match opt.as_str() {
+            "--export" => {
+                let path = match opts.next() {
+                    Some(path) => path,
+                    None => {
+                        println!("[!] --export requires a file");
+                        std::process::exit(1);
+                    },
+                };
+                writer = Some(ResultWriter::append(path).unwrap());
+            },
+            _ if opt.starts_with("--") => panic!("unknown option {}", opt),
+            _ => files.push(opt.clone()),
+        }
+    }
+    if files.is_empty() {
+        println!("[!] No trace files");
+        std::process::exit(1);
+    }
+
+    let mut traces = BinaryTraceSet::new_from_slice(&files);
+    loop {
+        let mut perf = PerfSummary::new("evaluate_local_pht");
+        let trace = match perf.time(Phase::Load, || traces.next()) {
+            Some(trace) => trace,
+            None => break,
+        };
         println!("[*] {}, {} records", trace.name(), trace.num_entries());
 
-        let stat = test_pht(4096, trace.as_slice());
+        let stat = perf.time(Phase::Eval, || test_pht(4096, trace.as_slice()));
+        perf.set_counts(trace.num_entries(), stat.global_brns());
         println!("Unique branches: {}", stat.num_unique_branches());
         println!("PHT entries: {}", 1 << 12);
         println!("Global hit rate: {:.2}% ({})", 
@@ -74,6 +80,9 @@ fn main() {
             stat.global_brns(),
         );
 
+        println!("Accuracy by confidence:");
+        print!("{}", stat.conf);
+
         println!("Low hit-rate branches:");
         for (pc, data) in stat.get_low_rate_branches(4) {
             println!("  {:016x} {:8}/{:8} {:.4}", 
@@ -81,8 +90,14 @@ fn main() {
             );
         }
         println!("  ...");
+        println!("{}", perf.summary());
         println!();
 
+        if let Some(w) = writer.as_mut() {
+            let table = ResultTable::from_branch_stats(trace.name(), &stat);
+            w.write(&table).unwrap();
+        }
+
     }
 
 }
@@ -0,0 +1,171 @@
+
+use dendrite::*;
+use std::env;
+use std::time::Instant;
+
+fn main() {
+    let args: Vec<String> = env::args().collect();
+    if args.len() < 2 {
+        println!("usage: {} <trace file> [<predictor>...] [--pipeline] \
+            [--batch <n>] [--threads <n>] [--huge-pages] \
+            [--checkpoint <file>] [--checkpoint-every <n>]", args[0]);
+        println!("  (predictors default to pht:12 gshare:12 perceptron:10 tage)");
+        println!("  --pipeline   decode the trace on a separate thread");
+        println!("  --threads n  divide predictors between 'n' threads, all \
+            sharing a single decoder thread");
+        println!("  --huge-pages request huge pages for tables and traces");
+        println!("  --checkpoint file  periodically save the evaluation, and \
+            resume from 'file' if it exists");
+        return;
+    }
+
+    // Decode the trace on a separate thread
+    let mut pipeline = false;
+    let mut num_threads = 0;
+    let mut batch_size = 4096;
+    let mut checkpoint_file = None;
+    let mut checkpoint_every = 10_000_000;
+    let mut spec_args = Vec::new();
+    let mut opts = args[2..].iter();
+    while let Some(opt) = opts.next() {
+        match opt.as_str() {
+            "--pipeline" => pipeline = true,
+            "--threads" => num_threads = parse_nonzero(opt, opts.next()),
+            "--batch" => batch_size = parse_nonzero(opt, opts.next()),
+            "--huge-pages" => set_huge_pages(true),
+            "--checkpoint" => {
+                checkpoint_file = Some(parse_path(opt, opts.next()));
+            },
+            "--checkpoint-every" => {
+                checkpoint_every = parse_nonzero(opt, opts.next());
+            },
+            _ => {
+                check_unknown_option(opt);
+                spec_args.push(opt.clone());
+            },
+        }
+    }
+
+    if checkpoint_file.is_some() && (pipeline || num_threads != 0) {
+        usage_error("--checkpoint cannot be combined with --pipeline or \
+            --threads");
+    }
+
+    let specs = if !spec_args.is_empty() {
+        parse_specs(&spec_args)
+    } else {
+        PredictorSpec::parse_list(&[
+            "pht:12".to_string(), 
+            "gshare:12".to_string(), 
+            "perceptron:10".to_string(), 
+            "tage".to_string(),
+        ]).unwrap()
+    };
+
+    // When the trace is decoded on another thread, loading is included in
+    // the evaluation time
+    let mut perf = PerfSummary::new("evaluate_multi");
+    if num_threads != 0 {
+        let mut eval = BroadcastEvaluator::from_specs(&specs, num_threads, 
+            16, batch_size);
+        let start = Instant::now();
+        let stats = eval.run_file(&args[1]).unwrap();
+        perf.add(Phase::Eval, start.elapsed());
+        println!("[*] Completed in {:.3?} ({} worker threads)", 
+            start.elapsed(), eval.workers.len());
+        println!("[*] Read {} records from {} ({} invalid, {} batches)", 
+            stats.num_records, args[1], stats.num_invalid, stats.num_batches);
+        for slot in eval.slots() {
+            print_slot(slot);
+        }
+        let slots = eval.slots();
+        perf.set_counts(stats.num_records, slots[0].stats.global_brns());
+        print_huge_pages();
+        println!("{}", perf.summary());
+        return;
+    }
+
+    let mut eval = MultiEvaluator::from_specs(&specs);
+    if pipeline {
+        let mut pipe = PipelinedEvaluator::new(eval, 8, batch_size);
+        let start = Instant::now();
+        let stats = pipe.run_file(&args[1]).unwrap();
+        perf.add(Phase::Eval, start.elapsed());
+        perf.num_records = stats.num_records;
+        println!("[*] Completed in {:.3?}", start.elapsed());
+        println!("[*] Read {} records from {} ({} invalid, {} batches)", 
+            stats.num_records, args[1], stats.num_invalid, stats.num_batches);
+        eval = pipe.eval;
+    } else {
+        let trace = perf.time(Phase::Load, || {
+            BinaryTrace::from_file(&args[1], "")
+        });
+        let trace_records = trace.as_slice();
+        println!("[*] Loaded {} records from {}", trace.num_entries(), args[1]);
+        let start = Instant::now();
+        match checkpoint_file.as_ref() {
+            Some(path) => {
+                let key = format!("evaluate_multi\t{}\t{}", args[1], 
+                    trace_records.len());
+                let c = Checkpointer::new(path, checkpoint_every, key);
+                run_checkpointed(&mut eval, trace_records, &c);
+            },
+            None => eval.run(trace_records),
+        }
+        perf.add(Phase::Eval, start.elapsed());
+        perf.num_records = trace_records.len();
+        println!("[*] Completed in {:.3?}", start.elapsed());
+    }
+
+    for slot in eval.slots.iter() {
+        print_slot(slot);
+    }
+    perf.num_conditional = eval.slots[0].stats.global_brns();
+    print_huge_pages();
+    println!("{}", perf.summary());
+}
+
+/// Evaluate a trace, periodically saving the state of the evaluation and
+/// resuming from the latest checkpoint.
+fn run_checkpointed(eval: &mut MultiEvaluator, records: &[BranchRecord], 
+    c: &Checkpointer)
+{
+    let start_pos = c.restore(|d| eval.restore_state(d))
+        .unwrap_or_else(|e| usage_error(e));
+    if let Some(pos) = start_pos {
+        println!("[*] Resumed from checkpoint at record {}", pos);
+    }
+    let start_pos = start_pos.unwrap_or(0);
+    for (idx, record) in records.iter().enumerate().skip(start_pos) {
+        eval.step(record);
+        if c.is_due(idx + 1) {
+            c.save(idx + 1, |e| eval.save_state(e)).unwrap();
+        }
+    }
+    c.remove().unwrap();
+}
+
+fn print_huge_pages() {
+    if huge_pages_enabled() {
+        println!("[*] Huge pages: {}", HugePageReport::collect());
+    }
+}
+
+fn print_slot(slot: &EvalSlot) {
+    let mpkb = slot.stats.global_miss() as f64 * 1000.0 
+        / slot.stats.global_brns() as f64;
+    println!("  {:20} Global hit rate: {}/{} ({:.2}% correct) ({:.3} MPKB)",
+        slot.name,
+        slot.stats.global_hits(),
+        slot.stats.global_brns(),
+        slot.stats.hit_rate() * 100.0,
+        mpkb,
+    );
+    let heap = slot.heap_usage();
+    println!("  {:20} Heap usage:      {:.2}KiB ({})", "", 
+        heap.bytes as f64 / 1024.0, 
+        heap.children.iter()
+            .map(|c| format!("{} {:.2}KiB", c.name, c.bytes as f64 / 1024.0))
+            .collect::<Vec<_>>().join(", "),
+    );
+}
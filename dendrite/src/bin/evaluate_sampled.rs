@@ -0,0 +1,89 @@
+
+use dendrite::*;
+use std::env;
+use std::time::Instant;
+
+fn main() {
+    let args: Vec<String> = env::args().collect();
+    if args.len() < 3 {
+        println!("usage: {} <trace file> <predictor> [--samples <n>] \
+            [--warmup <n>] [--measure <n>] [--random <seed>] \
+            [--confidence <level>] [--full]", args[0]);
+        println!("  --random seed  place windows randomly [instead of \
+            evenly spaced]");
+        println!("  --full         also run the entire trace and report \
+            the actual error");
+        return;
+    }
+
+    let spec = PredictorSpec::parse(&args[2])
+        .unwrap_or_else(|e| usage_error(e));
+    let mut num_samples = 50;
+    let mut warmup = 100_000;
+    let mut measure = 10_000;
+    let mut strategy = SampleStrategy::Systematic;
+    let mut level = 0.95;
+    let mut full = false;
+    let mut opts = args[3..].iter();
+    while let Some(opt) = opts.next() {
+        match opt.as_str() {
+            "--samples" => num_samples = parse_nonzero(opt, opts.next()),
+            "--warmup" => warmup = parse_value(opt, opts.next()),
+            "--measure" => measure = parse_nonzero(opt, opts.next()),
+            "--random" => {
+                let seed = parse_value(opt, opts.next());
+                strategy = SampleStrategy::Random(seed);
+            },
+            "--confidence" => level = parse_value(opt, opts.next()),
+            "--full" => full = true,
+            _ => usage_error(format!("unknown option {}", opt)),
+        }
+    }
+    if !(level > 0.0 && level < 1.0) {
+        usage_error("--confidence must be between 0 and 1");
+    }
+
+    let mut perf = PerfSummary::new("evaluate_sampled");
+    let trace = perf.time(Phase::Load, || BinaryTrace::from_file(&args[1], ""));
+    let trace_records = trace.as_slice();
+    println!("[*] Loaded {} records from {}", trace.num_entries(), args[1]);
+    println!("[*] {} samples ({:?}), {} warmup + {} measured records each", 
+        num_samples, strategy, warmup, measure);
+
+    let eval = SampledEvaluator::new(spec.clone(), num_samples, warmup, 
+        measure, strategy);
+    let start = Instant::now();
+    let res = eval.run(trace_records).unwrap_or_else(|e| usage_error(e));
+    let done = start.elapsed();
+    perf.add(Phase::Eval, done);
+    perf.set_counts(res.num_simulated, res.brns.iter().sum());
+
+    let mpkb = res.mpkb();
+    let interval = res.mpkb_interval(level);
+    println!("[*] Completed in {:.3?} ({:.2}% of records simulated)", done,
+        res.num_simulated as f64 * 100.0 / trace_records.len() as f64);
+    println!("[*] Estimated MPKB:  {:.3} +/- {:.3} ({:.0}% confidence, \
+        {:.2}% relative)", mpkb, interval, level * 100.0, 
+        interval * 100.0 / mpkb);
+    println!("[*] MPKB stddev:     {:.3} between samples", res.mpkb_stddev());
+    for rel in [0.05, 0.02, 0.01] {
+        println!("    Samples for +/- {:.0}%: {}", rel * 100.0, 
+            res.required_samples(rel, level));
+    }
+
+    if full {
+        let start = Instant::now();
+        let mut eval = MultiEvaluator::from_specs(&[spec]);
+        eval.run(trace_records);
+        let stats = &eval.slots[0].stats;
+        let actual = stats.global_miss() as f64 * 1000.0 
+            / stats.global_brns() as f64;
+        let err = mpkb - actual;
+        println!("[*] Full run:        {:.3} MPKB in {:.3?} ({:.1}x slower)", 
+            actual, start.elapsed(), 
+            start.elapsed().as_secs_f64() / done.as_secs_f64());
+        println!("    Error:           {:+.3} MPKB ({}within the interval)",
+            err, if err.abs() <= interval { "" } else { "not " });
+    }
+    println!("{}", perf.summary());
+}
@@ -0,0 +1,67 @@
+
+use dendrite::*;
+use std::env;
+use std::time::Instant;
+
+fn main() {
+    let args: Vec<String> = env::args().collect();
+    if args.len() < 3 {
+        println!("usage: {} <trace file> <predictor> [--shards <n>] \
+            [--warmup <n>] [--sample <n>] [--threads <n>]", args[0]);
+        return;
+    }
+
+    let spec = PredictorSpec::parse(&args[2])
+        .unwrap_or_else(|e| usage_error(e));
+    let mut pool = WorkPool::with_available_parallelism();
+    let mut num_shards = None;
+    let mut warmup = 1_000_000;
+    let mut sample = 0;
+    let mut opts = args[3..].iter();
+    while let Some(opt) = opts.next() {
+        match opt.as_str() {
+            "--shards" => num_shards = Some(parse_nonzero(opt, opts.next())),
+            "--warmup" => warmup = parse_value(opt, opts.next()),
+            "--sample" => sample = parse_value(opt, opts.next()),
+            "--threads" => {
+                pool = WorkPool::new(parse_nonzero(opt, opts.next()));
+            },
+            _ => usage_error(format!("unknown option {}", opt)),
+        }
+    }
+    let num_shards = num_shards.unwrap_or(pool.num_threads());
+
+    let mut perf = PerfSummary::new("evaluate_sharded");
+    let trace = perf.time(Phase::Load, || BinaryTrace::from_file(&args[1], ""));
+    let trace_records = trace.as_slice();
+    println!("[*] Loaded {} records from {}", trace.num_entries(), args[1]);
+    println!("[*] {} shards, {} warmup records, {} threads", 
+        num_shards, warmup, pool.num_threads());
+
+    let eval = ShardedEvaluator::new(spec, pool, num_shards, warmup);
+    let start = Instant::now();
+    let stats = eval.run(trace_records);
+    perf.add(Phase::Eval, start.elapsed());
+    perf.set_counts(trace_records.len(), stats.global_brns());
+    println!("[*] Completed in {:.3?}", start.elapsed());
+    let mpkb = stats.global_miss() as f64 * 1000.0 / stats.global_brns() as f64;
+    println!("[*] Global hit rate: {}/{} ({:.2}% correct) ({:.3} MPKB)",
+        stats.global_hits(), stats.global_brns(), stats.hit_rate() * 100.0,
+        mpkb);
+
+    if sample != 0 {
+        let start = Instant::now();
+        let err = eval.estimate_error(trace_records, sample);
+        println!("[*] Error estimate over {} records ({:.3?}):", 
+            err.sample_len, start.elapsed());
+        println!("    Sequential: {:.4}% correct", 
+            err.sequential.hit_rate() * 100.0);
+        println!("    Sharded:    {:.4}% correct", 
+            err.sharded.hit_rate() * 100.0);
+        println!("    Error:      {:+.4}% ({:+.3} MPKB)", 
+            err.hit_rate_error() * 100.0, err.mpkb_error());
+    }
+
+    // Warmup is done by each shard, and is included in the evaluation time
+    println!("{}", perf.summary());
+}
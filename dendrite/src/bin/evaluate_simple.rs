@@ -4,20 +4,22 @@ use dendrite::stats::*;
 use dendrite::predictor::simple;
 use std::env;
 
-fn run_test(records: &[BranchRecord], p: impl SimplePredictor) {
-    let mut stat = BranchStats::new();
-
-    for record in records.iter().filter(|r| r.is_conditional()) { 
-        stat.update_global(record, p.predict());
-    }
+fn run_test<P>(records: &[BranchRecord], p: P) -> BranchStats
+    where P: SimplePredictor + ConditionalPredictor
+{
+    let name = p.name();
+    let mut eval = Evaluator::new(p);
+    eval.run(records);
+    let stat = &eval.stats;
 
     println!("  {:20} Global hit rate: {}/{} ({:.2}% correct) ({} misses)", 
-        p.name(),
+        name,
         stat.global_hits(), 
         stat.global_brns(), 
         stat.hit_rate() * 100.0, 
         stat.global_miss()
     );
+    eval.stats
 }
 
 fn main() {
@@ -26,15 +28,24 @@ fn main() {
         println!("usage: {} <trace file>", args[0]);
         return;
     }
-    let traces = BinaryTraceSet::new_from_slice(&args[1..]);
+    let mut traces = BinaryTraceSet::new_from_slice(&args[1..]);
 
-    for trace in traces {
+    loop {
+        let mut perf = PerfSummary::new("evaluate_simple");
+        let trace = match perf.time(Phase::Load, || traces.next()) {
+            Some(trace) => trace,
+            None => break,
+        };
         if trace.num_entries() < 100 { continue; }
         println!("[*] {}", trace.name());
         let records = trace.as_slice();
-        run_test(records, simple::RandomPredictor);
-        //run_test(records, simple::TakenPredictor);
-        //run_test(records, simple::NotTakenPredictor);
+        let stat = perf.time(Phase::Eval, || {
+            run_test(records, simple::RandomPredictor)
+            //run_test(records, simple::TakenPredictor);
+            //run_test(records, simple::NotTakenPredictor);
+        });
+        perf.set_counts(records.len(), stat.global_brns());
+        println!("{}", perf.summary());
     }
 
 }
@@ -0,0 +1,73 @@
+
+use dendrite::*;
+use std::env;
+use std::time::Instant;
+
+fn main() {
+    let args: Vec<String> = env::args().collect();
+    if args.len() < 4 {
+        println!("usage: {} <trace file> <simpoint file> <predictor>... \
+            [--warmup <n>] [--full]", args[0]);
+        println!("  (simpoint files are written by find_simpoints)");
+        println!("  --full  also run the entire trace and report the error");
+        return;
+    }
+
+    let mut warmup = 100_000;
+    let mut full = false;
+    let mut spec_args = Vec::new();
+    let mut opts = args[3..].iter();
+    while let Some(opt) = opts.next() {
+        match opt.as_str() {
+            "--warmup" => warmup = parse_value(opt, opts.next()),
+            "--full" => full = true,
+            _ => {
+                check_unknown_option(opt);
+                spec_args.push(opt.clone());
+            },
+        }
+    }
+    let specs = parse_specs(&spec_args);
+
+    let mut perf = PerfSummary::new("evaluate_simpoints");
+    let trace = perf.time(Phase::Load, || BinaryTrace::from_file(&args[1], ""));
+    let trace_records = trace.as_slice();
+    println!("[*] Loaded {} records from {}", trace.num_entries(), args[1]);
+    let list = SimPointList::read(&args[2], trace_records.len())
+        .unwrap_or_else(|e| usage_error(e));
+    println!("[*] {} simpoints of {} records, {} warmup records", 
+        list.points.len(), list.interval_len, warmup);
+
+    let eval = SimPointEvaluator::new(&specs, warmup);
+    let start = Instant::now();
+    let res = eval.run(trace_records, &list);
+    let done = start.elapsed();
+    perf.add(Phase::Eval, done);
+    perf.set_counts(res.num_simulated, res.brns[0].iter().sum());
+    println!("[*] Completed in {:.3?} ({:.2}% of records simulated, \
+        {:.2}% measured)", done,
+        res.num_simulated as f64 * 100.0 / trace_records.len() as f64,
+        res.num_measured as f64 * 100.0 / trace_records.len() as f64);
+
+    let actual = if full {
+        let start = Instant::now();
+        let mut eval = MultiEvaluator::from_specs(&specs);
+        eval.run(trace_records);
+        println!("[*] Full run completed in {:.3?}", start.elapsed());
+        Some(eval.slots.iter().map(|s| {
+            s.stats.global_miss() as f64 * 1000.0 / s.stats.global_brns() as f64
+        }).collect::<Vec<_>>())
+    } else {
+        None
+    };
+
+    for (idx, name) in res.names.iter().enumerate() {
+        let mpkb = res.weighted_mpkb(idx);
+        match actual.as_ref() {
+            Some(a) => println!("  {:20} Weighted MPKB: {:.3} (full: {:.3}, \
+                error {:+.3})", name, mpkb, a[idx], mpkb - a[idx]),
+            None => println!("  {:20} Weighted MPKB: {:.3}", name, mpkb),
+        }
+    }
+    println!("{}", perf.summary());
+}
@@ -2,94 +2,14 @@
 use dendrite::*;
 use dendrite::stats::*;
 use itertools::*;
+use std::collections::*;
 use std::env;
 use std::time::Instant;
 use bitvec::prelude::*;
 
 
-/// Fold a program counter value into 12 bits. 
-///
-/// NOTE: I get the impression that this is unreasonably effective, but then
-/// again, we're folding 36 bits of the program counter, and this is probably
-/// expensive in hardware? 
-fn fold_pc_12b(pc: usize) -> usize { 
-    let lo  = pc & 0b0000_0000_0000_0000_0000_0000_1111_1111_1111;
-    let hi  = pc & 0b0000_0000_0000_1111_1111_1111_0000_0000_0000 >> 12;
-    let hi2 = pc & 0b1111_1111_1111_0000_0000_0000_0000_0000_0000 >> 24;
-    lo ^ hi ^ hi2
-}
-
-/// Index function into the base component.
-fn tage_base_fold_pc_12b(comp: &TAGEBaseComponent, pc: usize) -> usize { 
-    fold_pc_12b(pc)
-}
-
-/// Index function into a tagged component. 
-/// - 12 bits from the folded program counter value
-/// - 12 bits from the path history register
-/// - 12 bits from the folded global history register
-fn tage_fold_phr_ghist_12b(comp: &TAGEComponent, 
-    pc: usize, phr: &HistoryRegister) -> usize
-{
-    let pc_bits = fold_pc_12b(pc);
-    let phr_bits = phr.data()[0..=11].load::<usize>() & 0b1111_1111_1110;
-
-    let ghist_bits = comp.csr.output_usize(); 
-    ghist_bits ^ pc_bits ^ phr_bits
-
-}
-
-/// Hash function for computing a tag.
-fn tage_compute_tag(comp: &TAGEComponent, pc: usize) -> usize { 
-    let pc_bits = fold_pc_12b(pc);
-    let ghist0_bits = comp.csr.output_usize();
-    let ghist1_bits = comp.csr.output_usize() << 1;
-    (pc_bits ^ ghist0_bits ^ ghist1_bits) & ((1 << comp.cfg.tag_bits) -1)
-}
-
-/// Update the path history register. 
-/// - Fold program counter into 12 bits
-/// - Shift the PHR by one
-/// - XOR the folded program counter with the low 12 bits in the PHR
-fn update_phr(pc: usize, phr: &mut HistoryRegister) {
-    let pc_bits  = fold_pc_12b(pc);
-
-    phr.shift_by(1);
-    let phr_bits = phr.data()[0..=11].load::<usize>();
-    let new_bits = pc_bits ^ phr_bits;
-    phr.data_mut()[0..=11].store(new_bits);
-}
-
-
 fn build_tage() -> TAGEPredictor {
-    let mut tage_cfg = TAGEConfig::new(
-        TAGEBaseConfig { 
-            ctr: SaturatingCounterConfig {
-                max_t_state: 2,
-                max_n_state: 2,
-                default_state: Outcome::N,
-            },
-            size: 1 << 12,
-            index_strat: IndexStrategy::FromPc(tage_base_fold_pc_12b),
-        },
-    );
-
-    for ghr_range_hi in &[7, 15, 31, 63, 127] {
-        tage_cfg.add_component(
-            TAGEComponentConfig {
-                size: 1 << 12,
-                ghr_range: 0..=*ghr_range_hi,
-                tag_bits: 8,
-                useful_bits: 1,
-                ctr: SaturatingCounterConfig {
-                    max_t_state: 1,
-                    max_n_state: 1,
-                    default_state: Outcome::N,
-                },
-                index_strat: IndexStrategy::FromPhr(tage_fold_phr_ghist_12b),
-                tag_strat: TagStrategy::FromPc(tage_compute_tag),
-        });
-    }
+    let tage_cfg = TAGEConfig::preset_default();
 
     //println!("[*] {:#?}", tage_cfg);
     println!("[*] TAGE entries (in total): {}", tage_cfg.total_entries());
@@ -100,114 +20,264 @@ fn build_tage() -> TAGEPredictor {
         storage_bits, storage_kib
     );
 
-    tage_cfg.build()
+    let tage = tage_cfg.build();
+    let heap_bytes = tage.heap_bytes();
+    println!("[*] TAGE heap bytes:   {}B, {:.2}KiB (host)", 
+        heap_bytes, heap_bytes as f64 / 1024.0
+    );
+    tage
 }
 
 fn test_tage() {
 }
 
+/// Write the state of the evaluation to a checkpoint.
+fn save_state(e: &mut Encoder, eval: &Evaluator<TAGEPredictor>, 
+    recorder: &WindowRecorder, providers: &BTreeMap<usize, Vec<u64>>)
+{
+    eval.save_state(e);
+    recorder.save_state(e);
+    e.put_usize(providers.len());
+    for (pc, counts) in providers.iter() {
+        e.put_usize(*pc);
+        e.put_slice(counts);
+    }
+}
+
+/// Restore the state of the evaluation from a checkpoint.
+fn restore_state(d: &mut Decoder, eval: &mut Evaluator<TAGEPredictor>, 
+    recorder: &mut WindowRecorder, providers: &mut BTreeMap<usize, Vec<u64>>)
+    -> Option<()>
+{
+    eval.restore_state(d)?;
+    recorder.restore_state(d)?;
+    providers.clear();
+    for _ in 0..d.get_usize()? {
+        let pc = d.get_usize()?;
+        providers.insert(pc, d.get_vec()?);
+    }
+    Some(())
+}
 
 fn main() {
 
     let args: Vec<String> = env::args().collect();
     if args.len() < 2 {
-        println!("usage: {} <trace file>", args[0]);
+        println!("usage: {} <trace file> [--window <n>] [--series <file>] \
+            [--export <file>] [--huge-pages] [--checkpoint <file>] \
+            [--checkpoint-every <n>] [--event-log <file>] \
+            [--event-ring <n>]", args[0]);
         return;
     }
 
-    let trace = BinaryTrace::from_file(&args[1], "");
+    // Optionally write a time series of per-window metrics
+    let mut window = 1000;
+    let mut series_file = None;
+    let mut export_file = None;
+    let mut checkpoint_file = None;
+    let mut checkpoint_every = 10_000_000;
+    let mut event_file = None;
+    let mut event_ring = None;
+    let mut opts = args[2..].iter();
+    while let Some(opt) = opts.next() {
+        match opt.as_str() {
+            "--window" => window = parse_nonzero(opt, opts.next()),
+            "--series" => series_file = Some(parse_path(opt, opts.next())),
+            "--export" => export_file = Some(parse_path(opt, opts.next())),
+            "--huge-pages" => set_huge_pages(true),
+            "--checkpoint" => {
+                checkpoint_file = Some(parse_path(opt, opts.next()));
+            },
+            "--checkpoint-every" => {
+                checkpoint_every = parse_nonzero(opt, opts.next());
+            },
+            "--event-log" => event_file = Some(parse_path(opt, opts.next())),
+            "--event-ring" => {
+                event_ring = Some(parse_nonzero(opt, opts.next()));
+            },
+            _ => usage_error(format!("unknown option {}", opt)),
+        }
+    }
+    if checkpoint_file.is_some() && series_file.is_some() {
+        usage_error("--series cannot be combined with --checkpoint");
+    }
+    if checkpoint_file.is_some() && event_file.is_some() {
+        // Resuming would truncate the log and lose the earlier events
+        usage_error("--event-log cannot be combined with --checkpoint");
+    }
+    if event_ring.is_some() && event_file.is_none() {
+        usage_error("--event-ring requires --event-log");
+    }
+
+    let mut perf = PerfSummary::new("evaluate_tage");
+    let trace = perf.time(Phase::Load, || BinaryTrace::from_file(&args[1], ""));
     let trace_records = trace.as_slice();
     println!("[*] Loaded {} records from {}", trace.num_entries(), args[1]);
 
-    let ghr_bits = 128;
-    let mut tage = build_tage();
-    let mut ghr  = HistoryRegister::new(ghr_bits);
-    let mut phr  = HistoryRegister::new(32);
-    println!("[*] GHR length: {}", ghr_bits);
-
-    // Randomize the state of global history before we start evaluating 
-    for _ in 0..64 {
-        ghr.shift_by(1);
-        ghr.data_mut().set(0, rand::random());
-        tage.update_history(&ghr);
+    let mut eval = Evaluator::new(build_tage());
+    eval.per_branch = true;
+    println!("[*] GHR length: {}", EvalHistory::GHR_BITS);
 
-        phr.shift_by(1);
-        phr.data_mut().set(0, rand::random());
+    // Optionally log every update [or only the most recent updates]
+    if let Some(path) = event_file.as_ref() {
+        let log = match event_ring {
+            Some(n) => TAGEEventLog::ring(n),
+            None => TAGEEventLog::to_file(path, 1 << 16).unwrap(),
+        };
+        eval.predictor.log = Some(Box::new(log));
+    }
 
+    // Track allocations and the provider for each prediction
+    let num_tagged = eval.predictor.num_tagged_components();
+    let mut metrics = vec!["alcs".to_string(), "prov_base".to_string()];
+    for idx in 0..num_tagged {
+        metrics.push(format!("prov_t{}", idx));
+    }
+    let metric_names: Vec<&str> = metrics.iter().map(|s| s.as_str()).collect();
+    let mut recorder = WindowRecorder::new(window, &metric_names);
+    if let Some(path) = series_file.as_ref() {
+        recorder = recorder.with_output(path).unwrap();
     }
 
-    let mut hits = 0;
-    let mut brns = 0;
-    let mut mpkb_cnts = Vec::new();
-    let mut mpkb_window = 0;
-    let mut stats = BranchStats::new();
+    // Per-branch provider counts (only collected when exporting results)
+    let mut providers: BTreeMap<usize, Vec<u64>> = BTreeMap::new();
+
+    // Resume from the latest checkpoint [if one exists]
+    let checkpointer = checkpoint_file.as_ref().map(|path| {
+        let key = format!("evaluate_tage\t{}\t{}", args[1], trace.num_entries());
+        Checkpointer::new(path, checkpoint_every, key)
+    });
+    let resume_pos = checkpointer.as_ref().and_then(|c| {
+        c.restore(|d| {
+            restore_state(d, &mut eval, &mut recorder, &mut providers)
+        }).unwrap_or_else(|e| usage_error(e))
+    });
+    if let Some(pos) = resume_pos {
+        println!("[*] Resumed from checkpoint at record {}", pos);
+    } else {
+        // Randomize the state of global history before we start evaluating 
+        let warmup_start = Instant::now();
+        for _ in 0..64 {
+            eval.hist.ghr.shift_by(1);
+            eval.hist.ghr.data_mut().set(0, rand::random());
+            eval.predictor.update_history(&eval.hist.ghr);
+
+            eval.hist.phr.shift_by(1);
+            eval.hist.phr.data_mut().set(0, rand::random());
 
-    let start = Instant::now();
-    for record in trace_records {
-        match record.kind { 
-            BranchKind::Invalid => unreachable!(),
-
-            // Record all unconditionally taken branches in the GHR and 
-            // propagate updates to the TAGE folded history registers
-            BranchKind::DirectJump |
-            BranchKind::IndirectJump |
-            BranchKind::DirectCall |
-            BranchKind::IndirectCall |
-            BranchKind::Return => {
-                ghr.shift_by(1);
-                ghr.data_mut().set(0, true);
-                tage.update_history(&ghr);
-                update_phr(record.pc, &mut phr);
-            },
+        }
+        perf.add(Phase::Warmup, warmup_start.elapsed());
+    }
 
-            // Use the TAGE predictor to evaluate conditional branches
-            BranchKind::DirectBranch => {
-                if brns % 1000 == 0 { 
-                    mpkb_cnts.push(mpkb_window);
-                    mpkb_window = 0;
-                }
-
-                let stat = stats.get_mut(record.pc);
-                stat.pat.push(record.outcome.into());
-
-                let inputs = TAGEInputs { 
-                    pc: record.pc,
-                    phr: &phr,
-                };
-                let p = tage.predict(inputs.clone());
-                if record.outcome == p.outcome {
-                    hits += 1;
-                    stat.hits += 1;
-                } else { 
-                    mpkb_window += 1;
-                }
-                stat.occ += 1;
-                brns += 1;
-
-                tage.update(inputs, p, record.outcome);
-                ghr.shift_by(1);
-                ghr.data_mut().set(0, record.outcome.into());
-                tage.update_history(&ghr);
-                update_phr(record.pc, &mut phr);
-            },
+    let start = Instant::now();
+    let start_pos = resume_pos.unwrap_or(0);
+    // Only count the work done by this run [not the restored statistics]
+    let restored_brns = eval.stats.global_brns();
+    for (idx, record) in trace_records.iter().enumerate().skip(start_pos) {
+        // The callback is only used for conditional branches
+        let alcs = eval.predictor.stat.alcs;
+        eval.step_with(record, |tage, record, p| {
+            let hit = record.outcome == p.outcome;
+            recorder.add(0, (tage.stat.alcs - alcs) as u64);
+            let prov_idx = match p.meta.provider {
+                TAGEProvider::Base => 0,
+                TAGEProvider::Tagged(idx) => 1 + idx,
+            };
+            recorder.add(1 + prov_idx, 1);
+            recorder.step(hit);
+            if export_file.is_some() {
+                providers.entry(record.pc)
+                    .or_insert_with(|| vec![0; 1 + num_tagged])
+                    [prov_idx] += 1;
+            }
+        });
+        if let Some(c) = checkpointer.as_ref().filter(|c| c.is_due(idx + 1)) {
+            c.save(idx + 1, |e| {
+                save_state(e, &eval, &recorder, &providers)
+            }).unwrap();
         }
     }
+    if let Some(c) = checkpointer.as_ref() {
+        c.remove().unwrap();
+    }
     let done = start.elapsed();
+    if let Some(log) = eval.predictor.log.as_mut() {
+        let path = event_file.as_ref().unwrap();
+        let res = match event_ring {
+            Some(_) => log.dump(path),
+            None => log.flush(),
+        };
+        if let Err(e) = res {
+            println!("[!] Failed to write TAGE events to {}: {}", path, e);
+            std::process::exit(1);
+        }
+        println!("[*] Wrote TAGE events to {} ({} logged)", path, 
+            log.num_events);
+    }
+    let series = recorder.finish().unwrap();
     println!("[*] Completed in {:.3?}", done);
+    let tage = &eval.predictor;
+    let stats = &eval.stats;
+    perf.add(Phase::Eval, done);
+    perf.set_counts(trace_records.len() - start_pos,
+        stats.global_brns() - restored_brns);
     println!("[*] {:#?}", tage.stat);
 
     println!("[*] Unique branches: {}", stats.num_unique_branches());
-    let hit_rate = hits as f64 / brns as f64; 
     println!("[*] Global hit rate: {}/{} ({:.2}% correct) ({} misses)", 
-        hits, brns, hit_rate*100.0, brns - hits);
-    let avg_mpkb = mpkb_cnts.iter().sum::<usize>() / mpkb_cnts.len();
-    println!("[*] Average MPKB:    {}/1000 ({:.4})", 
-        avg_mpkb, avg_mpkb as f64 / 1000.0);
+        stats.global_hits(), stats.global_brns(), stats.hit_rate() * 100.0, 
+        stats.global_miss());
+    // There are no windows when the trace has no conditional branches
+    if series.len() == 0 {
+        println!("[*] Average MPKB:    n/a");
+    } else {
+        let avg_mpkb = series.avg_mpkb();
+        println!("[*] Average MPKB:    {:.3}/1000 ({:.4})", 
+            avg_mpkb, avg_mpkb / 1000.0);
+    }
+    println!("[*] Accuracy by confidence:");
+    for line in stats.conf.to_string().lines() {
+        println!("    {}", line);
+    }
+    let range = series.iter_mpkb().fold(None, |acc: Option<(f64, f64)>, x| {
+        Some(acc.map_or((x, x), |(lo, hi)| (lo.min(x), hi.max(x))))
+    });
+    let range = match range {
+        Some((lo, hi)) => format!("{:.3} to {:.3}", lo, hi),
+        None => "n/a".to_string(),
+    };
+    println!("[*] MPKB range:      {} over {} windows of {}", 
+        range, series.len(), window);
+    if let Some(path) = series_file.as_ref() {
+        println!("[*] Wrote per-window metrics to {}", path);
+    }
 
     for (idx, comp) in tage.comp.iter().enumerate() {
         println!("[*] Component[{}] (GHR[{:03?}]): {:.2}% utilization", 
             idx, comp.cfg.ghr_range, comp.utilization());
     }
+    println!("[*] Heap usage (storage bits: {:.2}KiB modeled):", 
+        tage.cfg.storage_bits() as f64 / 1024.0 / 8.0);
+    for line in eval.heap_usage("total").to_string().lines() {
+        println!("    {}", line);
+    }
+    if huge_pages_enabled() {
+        println!("[*] Huge pages: {}", HugePageReport::collect());
+    }
+    println!("{}", perf.summary());
+
+    if let Some(path) = export_file.as_ref() {
+        let mut table = ResultTable::from_branch_stats(&args[1], stats);
+        table.add_global("alcs", tage.stat.alcs as u64);
+        table.add_global("failed_alcs", tage.stat.failed_alcs as u64);
+        for (idx, name) in metrics[1..].iter().enumerate() {
+            table.add_column(name, Column::U64(
+                providers.values().map(|p| p[idx]).collect()
+            ));
+        }
+        ResultWriter::append(path).unwrap().write(&table).unwrap();
+        println!("[*] Appended results to {}", path);
+    }
 
 
     let d: Vec<(&usize, &BranchData)> = stats.data.iter().collect();
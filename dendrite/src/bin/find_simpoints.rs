@@ -0,0 +1,59 @@
+
+use dendrite::*;
+use std::env;
+use std::time::Instant;
+
+fn main() {
+    let args: Vec<String> = env::args().collect();
+    if args.len() < 3 {
+        println!("usage: {} <trace file> <output file> [--interval <n>] \
+            [--dims <n>] [--max-k <n>] [--seed <n>] [--threads <n>]", 
+            args[0]);
+        return;
+    }
+
+    let mut pool = WorkPool::with_available_parallelism();
+    let mut interval_len = 100_000;
+    let mut dims = 15;
+    let mut max_k = 10;
+    let mut seed = 1;
+    let mut opts = args[3..].iter();
+    while let Some(opt) = opts.next() {
+        match opt.as_str() {
+            "--interval" => interval_len = parse_nonzero(opt, opts.next()),
+            "--dims" => dims = parse_nonzero(opt, opts.next()),
+            "--max-k" => max_k = parse_nonzero(opt, opts.next()),
+            "--seed" => seed = parse_value(opt, opts.next()),
+            "--threads" => {
+                pool = WorkPool::new(parse_nonzero(opt, opts.next()));
+            },
+            _ => usage_error(format!("unknown option {}", opt)),
+        }
+    }
+
+    let trace = BinaryTrace::from_file(&args[1], "");
+    let trace_records = trace.as_slice();
+    println!("[*] Loaded {} records from {}", trace.num_entries(), args[1]);
+
+    let start = Instant::now();
+    let vectors = IntervalVectors::build(trace_records, interval_len, dims, 
+        seed, &pool);
+    println!("[*] Built {} vectors ({} dimensions) in {:.3?}", 
+        vectors.len(), dims, start.elapsed());
+
+    let start = Instant::now();
+    let clustering = KMeans::new(seed)
+        .run_bic(&vectors.data, max_k, 0.9, &pool)
+        .unwrap_or_else(|| usage_error(format!("{} is empty", args[1])));
+    println!("[*] Selected k={} (bic={:.1}, sse={:.6}) in {:.3?}", 
+        clustering.k(), clustering.bic, clustering.sse, start.elapsed());
+
+    let list = SimPointList::from_clustering(&vectors, &clustering);
+    for p in list.points.iter() {
+        let range = vectors.interval(p.interval, trace_records.len());
+        println!("    interval {:6} (records {:?}): weight {:.4}", 
+            p.interval, range, p.weight);
+    }
+    list.write(&args[2]).unwrap();
+    println!("[*] Wrote {} simpoints to {}", list.points.len(), args[2]);
+}
@@ -0,0 +1,22 @@
+
+use dendrite::*;
+use std::env;
+
+fn main() {
+    let args: Vec<String> = env::args().collect();
+    if args.len() < 2 {
+        println!("usage: {} <results file>", args[0]);
+        return;
+    }
+
+    for table in ResultReader::open(&args[1]).unwrap() {
+        let table = table.unwrap();
+        println!("[*] {} ({} branches)", table.name, table.num_rows());
+        for (name, val) in table.globals.iter() {
+            println!("    {:12} {}", name, val);
+        }
+        let names: Vec<&str> = table.columns.iter()
+            .map(|(name, _)| name.as_str()).collect();
+        println!("    columns: {}", names.join(", "));
+    }
+}
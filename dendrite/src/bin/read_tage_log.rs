@@ -0,0 +1,92 @@
+
+use dendrite::*;
+use itertools::*;
+use std::collections::*;
+use std::env;
+
+fn main() {
+    let args: Vec<String> = env::args().collect();
+    if args.len() < 2 {
+        println!("usage: {} <event log> [--pc <hex>] [--from <n>] [--to <n>] \
+            [--misses] [--allocs] [--summary [<n>]]", args[0]);
+        return;
+    }
+
+    let mut pc = None;
+    let mut from = 0;
+    let mut to = u64::MAX;
+    let mut only_misses = false;
+    let mut only_allocs = false;
+    let mut summary = None;
+    let mut opts = args[2..].iter().peekable();
+    while let Some(opt) = opts.next() {
+        match opt.as_str() {
+            "--pc" => {
+                let s = opts.next().unwrap().trim_start_matches("0x");
+                pc = Some(u64::from_str_radix(s, 16).unwrap());
+            },
+            "--from" => from = opts.next().unwrap().parse().unwrap(),
+            "--to" => to = opts.next().unwrap().parse().unwrap(),
+            "--misses" => only_misses = true,
+            "--allocs" => only_allocs = true,
+            "--summary" => {
+                summary = match opts.peek().and_then(|s| s.parse().ok()) {
+                    Some(n) => { opts.next(); Some(n) },
+                    None => Some(20),
+                };
+            },
+            _ => panic!("unknown option {}", opt),
+        }
+    }
+
+    let reader = TAGEEventReader::open(&args[1]).unwrap();
+    let mut total = TAGEEventSummary::default();
+    let mut branches: BTreeMap<u64, TAGEEventSummary> = BTreeMap::new();
+    let mut num_resets = 0;
+    for event in reader {
+        if event.clk < from || event.clk >= to {
+            continue;
+        }
+        if pc.map_or(false, |pc| pc != event.pc) {
+            continue;
+        }
+        if only_misses && !event.is_miss() {
+            continue;
+        }
+        if only_allocs && event.alloc == TAGEAllocation::None {
+            continue;
+        }
+        total.add(&event);
+        num_resets += event.reset as usize;
+        if summary.is_some() {
+            branches.entry(event.pc).or_default().add(&event);
+        } else {
+            println!("{}", event);
+        }
+    }
+
+    println!("[*] {} events, {} misses, {} allocations ({} failed), \
+        {} resets", total.events, total.misses, total.allocs,
+        total.failed_allocs, num_resets);
+    for (prov, count) in total.providers.iter() {
+        let name = match prov {
+            0 => "base".to_string(),
+            x => format!("t{}", x - 1),
+        };
+        println!("    provider {:4}: {:10} ({:.2}%)", name, count,
+            *count as f64 * 100.0 / total.events.max(1) as f64);
+    }
+
+    if let Some(n) = summary {
+        println!("[*] Branches with the most misses:");
+        let iter = branches.iter()
+            .sorted_by(|x, y| y.1.misses.cmp(&x.1.misses))
+            .take(n);
+        for (pc, s) in iter {
+            println!("    {:016x}: {:8} events {:8} misses {:8} allocs \
+                {:8} failed", pc, s.events, s.misses, s.allocs,
+                s.failed_allocs);
+        }
+    }
+}
+
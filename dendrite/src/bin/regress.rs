@@ -0,0 +1,255 @@
+
+use dendrite::*;
+use dendrite::trace::assembler::*;
+use std::collections::*;
+use std::env;
+use std::time::Instant;
+
+/// Predictor configurations checked by the harness.
+/// Allocation in TAGE is seeded so that results are reproducible.
+const SPECS: &[&str] = &[
+    "taken", "pht:12", "gshare:12", "perceptron:10:32", "tage:1",
+];
+
+/// Number of records in each synthetic trace
+const SYNTHETIC_LEN: usize = 1 << 18;
+
+/// Nested loops with long trip counts, which need long global history.
+fn synthetic_nested() -> Vec<BranchRecord> {
+    let mut asm = TraceAssembler::new(0x0080_0000);
+    let outer = asm.create_label();
+    let inner = asm.create_label();
+    let skip = asm.create_label();
+
+    asm.bind_label(outer);
+    asm.pad(0x8);
+    asm.bind_label(inner);
+    asm.branch_to_label(skip, BranchPattern::NotTakenPeriodic(2));
+    asm.pad(0x18);
+    asm.bind_label(skip);
+    asm.branch_to_label(inner, BranchPattern::NotTakenPeriodic(37));
+    asm.branch_to_label(outer, BranchPattern::NotTakenPeriodic(97));
+    asm.jump_to_label(outer);
+    asm.compile(SYNTHETIC_LEN).data
+}
+
+/// Results for a single (trace, predictor) pair.
+#[derive(Clone, Copy, Debug)]
+struct Golden {
+    hits: usize,
+    brns: usize,
+    records_per_sec: f64,
+}
+
+type Key = (String, String);
+
+/// Read a file of golden results, where each line has the trace name, the
+/// predictor, and some number of values (separated by tabs). 
+///
+/// Returns an error if the file doesn't exist [unless 'bless' is set].
+fn read_table(path: &str, num_values: usize, bless: bool)
+    -> Result<BTreeMap<Key, Vec<String>>, String>
+{
+    let mut res = BTreeMap::new();
+    let text = match std::fs::read_to_string(path) {
+        Ok(text) => text,
+        Err(e) if bless && e.kind() == std::io::ErrorKind::NotFound => {
+            return Ok(res);
+        },
+        Err(e) => return Err(format!("couldn't read {}: {}", path, e)),
+    };
+    for line in text.lines().filter(|l| !l.starts_with('#') && !l.is_empty()) {
+        let f: Vec<&str> = line.split('\t').collect();
+        if f.len() != 2 + num_values {
+            return Err(format!("malformed line in {}: {}", path, line));
+        }
+        let values = f[2..].iter().map(|v| v.to_string()).collect();
+        res.insert((f[0].to_string(), f[1].to_string()), values);
+    }
+    Ok(res)
+}
+
+/// Return the git revision of the tree containing some file [or 'unknown'
+/// if it isn't in a repository].
+fn source_revision(path: &str) -> String {
+    let dir = std::path::Path::new(path).parent()
+        .filter(|d| !d.as_os_str().is_empty())
+        .unwrap_or(std::path::Path::new("."));
+    std::process::Command::new("git")
+        .args(["describe", "--always", "--dirty"])
+        .current_dir(dir)
+        .output()
+        .ok()
+        .filter(|out| out.status.success())
+        .map(|out| String::from_utf8_lossy(&out.stdout).trim().to_string())
+        .unwrap_or_else(|| "unknown".to_string())
+}
+
+/// Write the hit and branch counts for each result [which are the same on
+/// every machine], noting the revision that produced them.
+fn write_accuracy(path: &str, results: &BTreeMap<Key, Golden>) {
+    let mut text = format!("# blessed at {}\n", source_revision(path));
+    text += "# trace\tpredictor\thits\tbranches\n";
+    for ((trace, spec), r) in results.iter() {
+        text += &format!("{}\t{}\t{}\t{}\n", trace, spec, r.hits, r.brns);
+    }
+    std::fs::write(path, text).unwrap();
+}
+
+/// Write the throughput for each result [which depends on the machine].
+fn write_speed(path: &str, results: &BTreeMap<Key, Golden>) {
+    let mut text = String::from("# trace\tpredictor\trecords/sec\n");
+    for ((trace, spec), r) in results.iter() {
+        text += &format!("{}\t{}\t{:.0}\n", trace, spec, r.records_per_sec);
+    }
+    std::fs::write(path, text).unwrap();
+}
+
+/// Evaluate a predictor, keeping the best throughput over 'repeat' runs.
+fn measure(records: &[BranchRecord], spec: &PredictorSpec, repeat: usize)
+    -> Golden
+{
+    let mut res: Option<Golden> = None;
+    for _ in 0..repeat {
+        let mut eval = MultiEvaluator::from_specs(&[spec.clone()]);
+        let start = Instant::now();
+        eval.run(records);
+        let rps = records.len() as f64 / start.elapsed().as_secs_f64();
+        let stats = &eval.slots[0].stats;
+        let cur = Golden {
+            hits: stats.global_hits(),
+            brns: stats.global_brns(),
+            records_per_sec: rps,
+        };
+        // Results must also be reproducible between runs
+        if let Some(prev) = res.as_mut() {
+            assert!(prev.hits == cur.hits && prev.brns == cur.brns,
+                "{} is not deterministic", spec);
+            prev.records_per_sec = prev.records_per_sec.max(rps);
+        } else {
+            res = Some(cur);
+        }
+    }
+    res.unwrap()
+}
+
+fn main() {
+    let args: Vec<String> = env::args().collect();
+    if args.len() < 2 {
+        println!("usage: {} <golden file> [<trace file>...] [--bless] \
+            [--speed <file>] [--speed-tolerance <pct>] [--repeat <n>]", 
+            args[0]);
+        println!("  <golden file>  hit/branch counts for each trace and \
+            predictor (ie. regress/golden.tsv)");
+        println!("  --speed file   also compare throughput with results \
+            in a [machine-specific] file (ie. regress/speed.tsv, which is \
+            not committed)");
+        println!("  --bless        record the current results as golden \
+            results");
+        return;
+    }
+
+    let mut bless = false;
+    let mut speed_file = None;
+    let mut speed_tolerance = 10.0;
+    let mut repeat = 3;
+    let mut files = Vec::new();
+    let mut opts = args[2..].iter();
+    while let Some(opt) = opts.next() {
+        match opt.as_str() {
+            "--bless" => bless = true,
+            "--speed" => speed_file = opts.next().cloned(),
+            "--speed-tolerance" => {
+                speed_tolerance = opts.next().unwrap().parse().unwrap();
+            },
+            "--repeat" => repeat = opts.next().unwrap().parse().unwrap(),
+            _ => files.push(opt.clone()),
+        }
+    }
+
+    let specs: Vec<PredictorSpec> = SPECS.iter()
+        .map(|s| PredictorSpec::parse(s).unwrap())
+        .collect();
+    let mut traces: Vec<(String, Vec<BranchRecord>)> = vec![
+        ("synthetic:loop".to_string(), synthetic_loop(SYNTHETIC_LEN).data),
+        ("synthetic:nested".to_string(), synthetic_nested()),
+    ];
+    for path in files.iter() {
+        let trace = BinaryTrace::from_file(path, "");
+        traces.push((path.clone(), trace.as_slice().to_vec()));
+    }
+
+    // A missing file is only allowed when creating it
+    let tables = read_table(&args[1], 2, bless).and_then(|golden| {
+        let speed = match speed_file.as_ref() {
+            Some(path) => read_table(path, 1, bless)?,
+            None => BTreeMap::new(),
+        };
+        Ok((golden, speed))
+    });
+    let (golden, speed) = match tables {
+        Ok(t) => t,
+        Err(e) => {
+            println!("[!] {} (use --bless to create it)", e);
+            std::process::exit(1);
+        },
+    };
+
+    let mut results = BTreeMap::new();
+    let mut failures = 0;
+    for (name, records) in traces.iter() {
+        for spec in specs.iter() {
+            let key = (name.clone(), spec.to_string());
+            let res = measure(records, spec, repeat);
+            results.insert(key.clone(), res);
+
+            let expected = golden.get(&key).map(|g| {
+                (g[0].parse::<usize>().unwrap(), g[1].parse::<usize>().unwrap())
+            });
+            let mut status = match expected {
+                None => {
+                    failures += 1;
+                    "NEW".to_string()
+                },
+                Some((hits, brns)) if hits != res.hits || brns != res.brns => {
+                    failures += 1;
+                    format!("ACCURACY (expected {}/{})", hits, brns)
+                },
+                Some(_) => "ok".to_string(),
+            };
+            if speed_file.is_some() {
+                match speed.get(&key) {
+                    None => {
+                        failures += 1;
+                        status += " NEW SPEED";
+                    },
+                    Some(s) => {
+                        let rps: f64 = s[0].parse().unwrap();
+                        let change = (res.records_per_sec / rps - 1.0) * 100.0;
+                        if change < -speed_tolerance {
+                            failures += 1;
+                            status += &format!(" SPEED ({:+.1}%)", change);
+                        } else {
+                            status += &format!(" ({:+.1}%)", change);
+                        }
+                    },
+                }
+            }
+            println!("{:20} {:20} {:8}/{:8} {:12.0} rec/s  {}", 
+                name, spec.to_string(), res.hits, res.brns, res.records_per_sec, 
+                status);
+        }
+    }
+
+    if bless {
+        write_accuracy(&args[1], &results);
+        println!("[*] Wrote golden results to {}", args[1]);
+        if let Some(path) = speed_file.as_ref() {
+            write_speed(path, &results);
+            println!("[*] Wrote throughput results to {}", path);
+        }
+    } else if failures != 0 {
+        println!("[!] {} regressions", failures);
+        std::process::exit(1);
+    }
+}
@@ -6,6 +6,16 @@ use bitvec::prelude::*;
 #[repr(u32)]
 #[derive(Clone, Copy, Debug, PartialEq, Eq, PartialOrd, Ord, Hash)]
 pub enum Outcome { N = 0, T = 1 }
+impl Outcome {
+    /// Convert from the raw value used in trace files.
+    pub fn from_u32(x: u32) -> Option<Self> {
+        match x {
+            0 => Some(Self::N),
+            1 => Some(Self::T),
+            _ => None,
+        }
+    }
+}
 impl std::ops::Not for Outcome { 
     type Output = Self;
     fn not(self) -> Self { 
@@ -59,6 +69,21 @@ pub enum BranchKind {
     /// A return instruction.
     Return       = 0x81,
 }
+impl BranchKind {
+    /// Convert from the raw value used in trace files.
+    pub fn from_u32(x: u32) -> Option<Self> {
+        match x {
+            0x00 => Some(Self::Invalid),
+            0x10 => Some(Self::DirectBranch),
+            0x20 => Some(Self::DirectJump),
+            0x21 => Some(Self::IndirectJump),
+            0x40 => Some(Self::DirectCall),
+            0x41 => Some(Self::IndirectCall),
+            0x81 => Some(Self::Return),
+            _ => None,
+        }
+    }
+}
 
 
 /// A record of branch execution. 
@@ -0,0 +1,136 @@
+//! Saving and restoring the state of long-running evaluations.
+//!
+//! Predictors are configured with function pointers (ie. index strategies),
+//! so they can't be recreated from a file with [Codec]. Instead, the caller
+//! builds the evaluation as usual, and [SaveState] overwrites the mutable
+//! state of each object in place.
+
+use std::fs::File;
+use std::io::{ Read, Write };
+use crate::codec::*;
+
+/// Types whose mutable state can be saved and restored in place.
+pub trait SaveState {
+    /// Append the state of this object to an [Encoder].
+    fn save_state(&self, e: &mut Encoder);
+
+    /// Overwrite the state of this object with state read from a
+    /// [Decoder]. Returns [None] if the input is truncated, malformed,
+    /// or does not match the configuration of this object.
+    fn restore_state(&mut self, d: &mut Decoder) -> Option<()>;
+}
+
+impl <T: SaveState> SaveState for [T] {
+    fn save_state(&self, e: &mut Encoder) {
+        e.put_usize(self.len());
+        self.iter().for_each(|x| x.save_state(e));
+    }
+
+    fn restore_state(&mut self, d: &mut Decoder) -> Option<()> {
+        if d.get_usize()? != self.len() {
+            return None;
+        }
+        self.iter_mut().try_for_each(|x| x.restore_state(d))
+    }
+}
+
+/// Periodically writes the state of an evaluation to a file.
+///
+/// Each checkpoint is written to a temporary file which is renamed over
+/// the previous checkpoint, so a process killed while writing never leaves
+/// behind a partial checkpoint.
+///
+/// The 'key' identifies the evaluation (ie. the tool, predictor, and
+/// trace), and a checkpoint is only restored when the keys match.
+pub struct Checkpointer {
+    /// Path to the checkpoint file
+    pub path: String,
+
+    /// Number of records between checkpoints
+    pub interval: usize,
+
+    /// String identifying the evaluation
+    pub key: String,
+}
+impl Checkpointer {
+    pub const MAGIC: &'static [u8] = b"DCKP";
+
+    pub fn new(path: impl ToString, interval: usize, key: impl ToString)
+        -> Self
+    {
+        assert!(interval != 0);
+        Self { path: path.to_string(), interval, key: key.to_string() }
+    }
+
+    /// Returns 'true' when a checkpoint should be taken after evaluating
+    /// the first 'pos' records.
+    pub fn is_due(&self, pos: usize) -> bool {
+        pos % self.interval == 0
+    }
+
+    /// Restore the latest checkpoint [if one exists] with 'f'.
+    /// Returns the number of records that were already evaluated.
+    ///
+    /// Returns an [std::io::ErrorKind::InvalidData] error if the file is
+    /// not a checkpoint, belongs to a different evaluation, or the state 
+    /// cannot be restored.
+    pub fn restore(&self, f: impl FnOnce(&mut Decoder) -> Option<()>)
+        -> std::io::Result<Option<usize>>
+    {
+        let mut buf = Vec::new();
+        match File::open(&self.path) {
+            Ok(mut file) => { file.read_to_end(&mut buf)?; },
+            Err(e) if e.kind() == std::io::ErrorKind::NotFound => {
+                return Ok(None);
+            },
+            Err(e) => return Err(e),
+        }
+
+        let invalid = |msg: &str| {
+            std::io::Error::new(std::io::ErrorKind::InvalidData, 
+                format!("checkpoint {}: {}", self.path, msg))
+        };
+        let mut d = Decoder::new(&buf);
+        if d.get_raw(Self::MAGIC.len()) != Some(Self::MAGIC) {
+            return Err(invalid("not a checkpoint"));
+        }
+        let key = d.get_str().ok_or_else(|| invalid("truncated header"))?;
+        if key != self.key {
+            let msg = format!("for a different evaluation ({})", key);
+            return Err(invalid(&msg));
+        }
+        let pos = d.get_usize().ok_or_else(|| invalid("truncated header"))?;
+        f(&mut d).ok_or_else(|| invalid("failed to restore state"))?;
+        if !d.is_empty() {
+            return Err(invalid("trailing data after state"));
+        }
+        Ok(Some(pos))
+    }
+
+    /// Write a checkpoint after evaluating the first 'pos' records, where
+    /// 'f' writes the state of the evaluation.
+    pub fn save(&self, pos: usize, f: impl FnOnce(&mut Encoder))
+        -> std::io::Result<()>
+    {
+        let mut e = Encoder::new();
+        e.put_raw(Self::MAGIC);
+        e.put_str(&self.key);
+        e.put_usize(pos);
+        f(&mut e);
+
+        let tmp_path = format!("{}.tmp", self.path);
+        let mut file = File::create(&tmp_path)?;
+        file.write_all(e.as_bytes())?;
+        file.sync_all()?;
+        std::fs::rename(&tmp_path, &self.path)
+    }
+
+    /// Remove the checkpoint [ie. after the evaluation has completed].
+    pub fn remove(&self) -> std::io::Result<()> {
+        match std::fs::remove_file(&self.path) {
+            Err(e) if e.kind() != std::io::ErrorKind::NotFound => Err(e),
+            _ => Ok(()),
+        }
+    }
+}
+
@@ -0,0 +1,219 @@
+//! Helpers for compact binary serialization.
+//!
+//! Integers are written as LEB128 varints, so small counts only cost a
+//! single byte. Bit-vectors are packed into little-endian 64-bit words.
+
+use bitvec::prelude::*;
+
+/// Types that can be written to and read back from a compact binary format.
+pub trait Codec: Sized {
+    /// Append the binary representation of this object to an [Encoder].
+    fn encode(&self, e: &mut Encoder);
+
+    /// Read an object from a [Decoder].
+    /// Returns [None] if the input is truncated or malformed.
+    fn decode(d: &mut Decoder) -> Option<Self>;
+
+    /// Serialize this object into a new buffer.
+    fn to_bytes(&self) -> Vec<u8> {
+        let mut e = Encoder::new();
+        self.encode(&mut e);
+        e.finish()
+    }
+
+    /// Deserialize an object from a buffer.
+    fn from_bytes(buf: &[u8]) -> Option<Self> {
+        let mut d = Decoder::new(buf);
+        Self::decode(&mut d)
+    }
+}
+
+/// Buffer used to build the binary representation of some object.
+pub struct Encoder {
+    buf: Vec<u8>,
+}
+impl Encoder {
+    pub fn new() -> Self {
+        Self { buf: Vec::new() }
+    }
+
+    /// Return the encoded bytes.
+    pub fn finish(self) -> Vec<u8> { self.buf }
+
+    /// Return a reference to the encoded bytes.
+    pub fn as_bytes(&self) -> &[u8] { &self.buf }
+
+    /// Return the number of encoded bytes.
+    pub fn len(&self) -> usize { self.buf.len() }
+
+    pub fn put_u8(&mut self, val: u8) {
+        self.buf.push(val);
+    }
+
+    /// Write some bytes [without a length prefix].
+    pub fn put_raw(&mut self, val: &[u8]) {
+        self.buf.extend_from_slice(val);
+    }
+
+    /// Write an unsigned integer as a LEB128 varint.
+    pub fn put_varint(&mut self, mut val: u64) {
+        while val >= 0x80 {
+            self.buf.push((val as u8) | 0x80);
+            val >>= 7;
+        }
+        self.buf.push(val as u8);
+    }
+
+    pub fn put_usize(&mut self, val: usize) {
+        self.put_varint(val as u64);
+    }
+
+    pub fn put_u64(&mut self, val: u64) {
+        self.buf.extend_from_slice(&val.to_le_bytes());
+    }
+
+    pub fn put_f64(&mut self, val: f64) {
+        self.buf.extend_from_slice(&val.to_le_bytes());
+    }
+
+    /// Write a length-prefixed byte string.
+    pub fn put_bytes(&mut self, val: &[u8]) {
+        self.put_usize(val.len());
+        self.buf.extend_from_slice(val);
+    }
+
+    pub fn put_str(&mut self, val: &str) {
+        self.put_bytes(val.as_bytes());
+    }
+
+    /// Write a length-prefixed slice of bits.
+    pub fn put_bits(&mut self, bits: &BitSlice) {
+        self.put_usize(bits.len());
+        for chunk in bits.chunks(64) {
+            self.put_u64(chunk.load_le::<u64>());
+        }
+    }
+
+    /// Write a length-prefixed list of objects.
+    pub fn put_slice<T: Codec>(&mut self, val: &[T]) {
+        self.put_usize(val.len());
+        for x in val {
+            x.encode(self);
+        }
+    }
+}
+
+/// Cursor used to read objects from some binary representation.
+pub struct Decoder<'a> {
+    buf: &'a [u8],
+    pos: usize,
+}
+impl <'a> Decoder<'a> {
+    pub fn new(buf: &'a [u8]) -> Self {
+        Self { buf, pos: 0 }
+    }
+
+    /// Return the number of bytes consumed so far.
+    pub fn pos(&self) -> usize { self.pos }
+
+    /// Return the number of bytes left in the buffer.
+    pub fn remaining(&self) -> usize { self.buf.len() - self.pos }
+
+    /// Returns 'true' when the entire buffer has been consumed.
+    pub fn is_empty(&self) -> bool { self.remaining() == 0 }
+
+    /// Consume 'n' bytes.
+    pub fn get_raw(&mut self, n: usize) -> Option<&'a [u8]> {
+        if self.remaining() < n {
+            return None;
+        }
+        let res = &self.buf[self.pos..self.pos + n];
+        self.pos += n;
+        Some(res)
+    }
+
+    pub fn get_u8(&mut self) -> Option<u8> {
+        self.get_raw(1).map(|b| b[0])
+    }
+
+    /// Read a LEB128 varint.
+    pub fn get_varint(&mut self) -> Option<u64> {
+        let mut res = 0u64;
+        let mut shift = 0;
+        loop {
+            let byte = self.get_u8()?;
+            if shift >= 64 {
+                return None;
+            }
+            res |= ((byte & 0x7f) as u64) << shift;
+            if byte & 0x80 == 0 {
+                return Some(res);
+            }
+            shift += 7;
+        }
+    }
+
+    pub fn get_usize(&mut self) -> Option<usize> {
+        self.get_varint().map(|v| v as usize)
+    }
+
+    pub fn get_u64(&mut self) -> Option<u64> {
+        let b = self.get_raw(8)?;
+        Some(u64::from_le_bytes(b.try_into().unwrap()))
+    }
+
+    pub fn get_f64(&mut self) -> Option<f64> {
+        let b = self.get_raw(8)?;
+        Some(f64::from_le_bytes(b.try_into().unwrap()))
+    }
+
+    /// Read a length-prefixed byte string.
+    pub fn get_bytes(&mut self) -> Option<&'a [u8]> {
+        let len = self.get_usize()?;
+        self.get_raw(len)
+    }
+
+    pub fn get_str(&mut self) -> Option<String> {
+        let b = self.get_bytes()?;
+        String::from_utf8(b.to_vec()).ok()
+    }
+
+    /// Read a length-prefixed slice of bits.
+    pub fn get_bits(&mut self) -> Option<BitVec> {
+        let len = self.get_usize()?;
+        // A corrupt length must not overflow [and wrap to a small size]
+        let num_words = len.checked_add(63)? / 64;
+        if self.remaining() < num_words.checked_mul(8)? {
+            return None;
+        }
+        let mut res = BitVec::repeat(false, len);
+        for idx in 0..num_words {
+            let word = self.get_u64()?;
+            let lo = idx * 64;
+            let hi = (lo + 64).min(len);
+            res[lo..hi].store_le::<u64>(word);
+        }
+        Some(res)
+    }
+
+    /// Read a length-prefixed list of objects.
+    pub fn get_vec<T: Codec>(&mut self) -> Option<Vec<T>> {
+        let len = self.get_usize()?;
+        let mut res = Vec::with_capacity(len.min(self.remaining()));
+        for _ in 0..len {
+            res.push(T::decode(self)?);
+        }
+        Some(res)
+    }
+}
+
+impl Codec for usize {
+    fn encode(&self, e: &mut Encoder) { e.put_usize(*self); }
+    fn decode(d: &mut Decoder) -> Option<Self> { d.get_usize() }
+}
+
+impl Codec for u64 {
+    fn encode(&self, e: &mut Encoder) { e.put_varint(*self); }
+    fn decode(d: &mut Decoder) -> Option<Self> { d.get_varint() }
+}
+
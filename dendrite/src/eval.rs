@@ -0,0 +1,225 @@
+//! Helpers for driving predictors with a trace.
+
+pub mod spec;
+pub mod predictors;
+pub mod single;
+pub mod multi;
+pub mod grid;
+pub mod shard;
+pub mod sample;
+pub mod simpoint;
+pub mod context;
+pub mod pipeline;
+pub mod diff;
+pub mod filter;
+
+pub use spec::*;
+pub use single::*;
+pub use multi::*;
+pub use grid::*;
+pub use shard::*;
+pub use sample::*;
+pub use simpoint::*;
+pub use context::*;
+pub use pipeline::*;
+pub use diff::*;
+pub use filter::*;
+
+use crate::branch::*;
+use crate::checkpoint::*;
+use crate::codec::*;
+use crate::heap::*;
+use crate::history::*;
+use crate::predictor::*;
+
+/// History registers shared by all predictors in an evaluation.
+///
+/// Conditional branches shift their outcome into global history, and all 
+/// other branches shift in a 'taken' bit. Every branch updates the path
+/// history register (see [update_phr]).
+#[derive(Clone, Debug)]
+pub struct EvalHistory {
+    /// Global history register
+    pub ghr: HistoryRegister,
+
+    /// Path history register
+    pub phr: HistoryRegister,
+}
+impl HeapSize for EvalHistory {
+    fn heap_bytes(&self) -> usize {
+        self.ghr.heap_bytes() + self.phr.heap_bytes()
+    }
+}
+impl SaveState for EvalHistory {
+    fn save_state(&self, e: &mut Encoder) {
+        self.ghr.save_state(e);
+        self.phr.save_state(e);
+    }
+
+    fn restore_state(&mut self, d: &mut Decoder) -> Option<()> {
+        self.ghr.restore_state(d)?;
+        self.phr.restore_state(d)
+    }
+}
+impl EvalHistory {
+    /// Length of the global history register [in bits]
+    pub const GHR_BITS: usize = 128;
+
+    /// Length of the path history register [in bits]
+    pub const PHR_BITS: usize = 32;
+
+    pub fn new() -> Self {
+        Self {
+            ghr: HistoryRegister::new(Self::GHR_BITS),
+            phr: HistoryRegister::new(Self::PHR_BITS),
+        }
+    }
+
+    /// Clear both history registers.
+    pub fn reset(&mut self) {
+        self.ghr.reset();
+        self.phr.reset();
+    }
+
+    /// Update history with some branch record.
+    pub fn update(&mut self, record: &BranchRecord) {
+        self.update_folded(record, fold_pc_12b(record.pc));
+    }
+
+    /// Update history with some branch record, given the program counter 
+    /// folded with [fold_pc_12b].
+    pub fn update_folded(&mut self, record: &BranchRecord, pc_bits: usize) {
+        let bit = if record.is_conditional() {
+            record.outcome.into()
+        } else {
+            true
+        };
+        self.ghr.shift_by(1);
+        self.ghr.data_mut().set(0, bit);
+        update_phr_folded(pc_bits, &mut self.phr);
+    }
+}
+
+/// Interface to a predictor driven by an evaluator.
+pub trait EvalPredictor {
+    /// Make a prediction for some conditional branch, then update the 
+    /// predictor with the resolved outcome. 
+    ///
+    /// Returns the predicted direction and the confidence in the prediction.
+    fn step(&mut self, record: &BranchRecord, hist: &EvalHistory) 
+        -> (Outcome, Confidence);
+
+    /// Called after the shared history has been updated with some branch.
+    fn update_history(&mut self, hist: &EvalHistory) {}
+
+    /// Return the predictor to its initial state [without reallocating].
+    fn reset(&mut self);
+
+    /// Return how much of the predictor's capacity is in use, for
+    /// predictors which allocate entries on demand.
+    fn capacity(&self) -> Option<PredictorCapacity> { None }
+
+    /// Return a breakdown of the memory used by this predictor on the host.
+    fn heap_usage(&self, name: &str) -> HeapUsage;
+
+    /// Save the state of this predictor (see [SaveState]).
+    fn save_state(&self, e: &mut Encoder);
+
+    /// Restore the state of this predictor (see [SaveState]).
+    fn restore_state(&mut self, d: &mut Decoder) -> Option<()>;
+}
+
+/// Use of the entries in a predictor which allocates entries on demand
+/// [ie. the tagged components in a [TAGEPredictor]].
+#[derive(Clone, Copy, Debug, Default, PartialEq, Eq)]
+pub struct PredictorCapacity {
+    /// Number of successful allocations
+    pub allocs: usize,
+
+    /// Number of failed allocations
+    pub failed_allocs: usize,
+
+    /// Number of entries currently allocated
+    pub used: usize,
+
+    /// Total number of entries
+    pub entries: usize,
+}
+
+/// A prediction made by a [ConditionalPredictor].
+#[derive(Clone, Copy, Debug)]
+pub struct BranchPrediction<M> {
+    /// Predicted direction
+    pub outcome: Outcome,
+
+    /// Confidence in the predicted direction
+    pub confidence: Confidence,
+
+    /// Predictor-specific information needed to update the predictor
+    pub meta: M,
+}
+
+/// Common interface to predictors for conditional branches.
+///
+/// Any state computed while making a prediction (ie. table indexes) that is
+/// also needed for the update is kept in [ConditionalPredictor::Meta], so
+/// it doesn't need to be computed again. 
+pub trait ConditionalPredictor {
+    /// Information passed from a prediction to the following update
+    type Meta;
+
+    /// Make a prediction for some conditional branch.
+    fn predict_branch(&mut self, record: &BranchRecord, hist: &EvalHistory)
+        -> BranchPrediction<Self::Meta>;
+
+    /// Update the predictor with the resolved outcome of a branch. 
+    fn update_branch(&mut self, record: &BranchRecord, hist: &EvalHistory,
+        prediction: &BranchPrediction<Self::Meta>);
+
+    /// Called after the shared history has been updated with some branch.
+    fn update_history(&mut self, hist: &EvalHistory) {}
+
+    /// Return the predictor to its initial state [without reallocating].
+    fn reset(&mut self);
+
+    /// Return how much of the predictor's capacity is in use, for
+    /// predictors which allocate entries on demand.
+    fn capacity(&self) -> Option<PredictorCapacity> { None }
+}
+
+impl <P> EvalPredictor for P
+    where P: ConditionalPredictor + HeapSize + SaveState
+{
+    fn step(&mut self, record: &BranchRecord, hist: &EvalHistory) 
+        -> (Outcome, Confidence)
+    {
+        let p = self.predict_branch(record, hist);
+        self.update_branch(record, hist, &p);
+        (p.outcome, p.confidence)
+    }
+
+    fn update_history(&mut self, hist: &EvalHistory) {
+        ConditionalPredictor::update_history(self, hist);
+    }
+
+    fn reset(&mut self) {
+        ConditionalPredictor::reset(self);
+    }
+
+    fn capacity(&self) -> Option<PredictorCapacity> {
+        ConditionalPredictor::capacity(self)
+    }
+
+    fn heap_usage(&self, name: &str) -> HeapUsage {
+        HeapSize::heap_usage(self, name)
+    }
+
+    fn save_state(&self, e: &mut Encoder) {
+        SaveState::save_state(self, e)
+    }
+
+    fn restore_state(&mut self, d: &mut Decoder) -> Option<()> {
+        SaveState::restore_state(self, d)
+    }
+}
+
@@ -0,0 +1,172 @@
+
+use crate::branch::*;
+use crate::eval::*;
+use crate::stats::*;
+
+/// How predictor state is shared between contexts in a [ContextEvaluator].
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum ContextMode {
+    /// All contexts share a single predictor and history
+    Shared,
+
+    /// All contexts share a single predictor, but the predictor and history
+    /// are reset on every context switch
+    Flush,
+
+    /// Each context has a private predictor [with an equal share of the
+    /// table entries] and private history
+    Partition,
+
+    /// All contexts share a single predictor, but the context ID is hashed
+    /// into the program counter, so each context mostly uses different
+    /// entries and tags
+    Tag,
+}
+impl ContextMode {
+    pub fn parse(s: &str) -> Result<Self, String> {
+        match s {
+            "shared" => Ok(Self::Shared),
+            "flush" => Ok(Self::Flush),
+            "partition" => Ok(Self::Partition),
+            "tag" => Ok(Self::Tag),
+            _ => Err(format!("invalid context mode '{}'", s)),
+        }
+    }
+}
+
+/// Evaluates a single predictor configuration on several traces at once,
+/// switching between them in a round-robin order (ie. to model context
+/// switches or simultaneous multithreading).
+///
+/// Each trace is one context. After 'quantum' records from one context,
+/// the evaluator switches to the next context with records remaining.
+/// Switching only moves between cursors into each trace; the interleaved
+/// trace is never built.
+///
+/// NOTE: Except in [ContextMode::Partition], contexts also share a single
+/// set of history registers. Predictors like [TAGEPredictor] keep folded
+/// copies of global history, which can't be swapped out on a switch.
+pub struct ContextEvaluator {
+    pub spec: PredictorSpec,
+    pub mode: ContextMode,
+
+    /// Number of records evaluated before switching contexts
+    pub quantum: usize,
+
+    /// Predictors [one for each context when partitioned]
+    predictors: Vec<Box<dyn EvalPredictor + Send>>,
+
+    /// History registers [one for each context when partitioned]
+    hist: Vec<EvalHistory>,
+
+    /// Statistics collected for each context
+    pub stats: Vec<BranchStats>,
+
+    /// Number of context switches
+    pub num_switches: usize,
+}
+impl ContextEvaluator {
+    /// Returns an error if 'quantum' or 'num_contexts' is zero, or if the
+    /// predictor cannot be partitioned between 'num_contexts' contexts
+    /// (see [PredictorSpec::build_partition]).
+    pub fn new(spec: PredictorSpec, mode: ContextMode, quantum: usize,
+        num_contexts: usize) -> Result<Self, String>
+    {
+        if quantum == 0 {
+            return Err("the quantum must be at least one record".to_string());
+        }
+        if num_contexts == 0 {
+            return Err("at least one context is required".to_string());
+        }
+        let (predictors, hist) = match mode {
+            ContextMode::Partition => {
+                let parts = num_contexts.next_power_of_two();
+                let p = (0..num_contexts)
+                    .map(|_| spec.build_partition(parts))
+                    .collect::<Result<_, _>>()?;
+                let h = (0..num_contexts).map(|_| EvalHistory::new()).collect();
+                (p, h)
+            },
+            _ => (vec![spec.build()], vec![EvalHistory::new()]),
+        };
+        Ok(Self {
+            spec,
+            mode,
+            quantum,
+            predictors,
+            hist,
+            stats: (0..num_contexts).map(|_| BranchStats::new()).collect(),
+            num_switches: 0,
+        })
+    }
+
+    /// Return a value XOR'ed into the program counter for some context in
+    /// [ContextMode::Tag]. This only changes the low 36 bits [which are
+    /// used by index and tag functions like [fold_pc_12b]].
+    pub fn context_tag(ctx: usize) -> usize {
+        if ctx == 0 {
+            return 0;
+        }
+        let h = (ctx as u64).wrapping_mul(0x9e37_79b9_7f4a_7c15);
+        ((h ^ (h >> 29)) & 0xf_ffff_ffff) as usize
+    }
+
+    /// Called before evaluating records from another context.
+    fn switch(&mut self) {
+        self.num_switches += 1;
+        if self.mode == ContextMode::Flush {
+            self.predictors[0].reset();
+            self.hist[0].reset();
+        }
+    }
+
+    /// Evaluate some records from a single context.
+    fn run_quantum(&mut self, ctx: usize, records: &[BranchRecord]) {
+        let (idx, tag) = match self.mode {
+            ContextMode::Partition => (ctx, 0),
+            ContextMode::Tag => (0, Self::context_tag(ctx)),
+            _ => (0, 0),
+        };
+        let predictor = &mut self.predictors[idx];
+        let hist = &mut self.hist[idx];
+        let stats = &mut self.stats[ctx];
+        for record in records {
+            let mut record = *record;
+            record.pc ^= tag;
+            if record.is_conditional() {
+                let (outcome, conf) = predictor.step(&record, hist);
+                stats.update_global(&record, outcome);
+                stats.update_confidence(&record, outcome, conf);
+            }
+            hist.update(&record);
+            predictor.update_history(hist);
+        }
+    }
+
+    /// Evaluate a set of traces [one for each context].
+    pub fn run(&mut self, traces: &[&[BranchRecord]]) {
+        assert!(traces.len() == self.stats.len());
+        let mut pos = vec![0; traces.len()];
+        let mut prev = None;
+        loop {
+            let mut done = true;
+            for ctx in 0..traces.len() {
+                let end = (pos[ctx] + self.quantum).min(traces[ctx].len());
+                if pos[ctx] == end {
+                    continue;
+                }
+                done = false;
+                if prev.is_some() && prev != Some(ctx) {
+                    self.switch();
+                }
+                self.run_quantum(ctx, &traces[ctx][pos[ctx]..end]);
+                pos[ctx] = end;
+                prev = Some(ctx);
+            }
+            if done {
+                break;
+            }
+        }
+    }
+}
+
@@ -0,0 +1,174 @@
+
+use std::fmt::Debug;
+use crate::branch::*;
+use crate::eval::*;
+use crate::checkpoint::*;
+use crate::codec::*;
+use crate::heap::*;
+use crate::predictor::*;
+
+/// The first point where two predictors disagree in a [LockstepEvaluator].
+#[derive(Clone, Debug)]
+pub struct Divergence {
+    /// Index of the record in the trace
+    pub index: usize,
+
+    /// The record being evaluated
+    pub record: BranchRecord,
+
+    /// Description of the difference
+    pub reason: String,
+
+    /// State of the reference predictor
+    pub reference: String,
+
+    /// State of the optimized predictor
+    pub optimized: String,
+}
+impl std::fmt::Display for Divergence {
+    fn fmt(&self, f: &mut std::fmt::Formatter) -> std::fmt::Result {
+        writeln!(f, "Divergence at record {}: {}", self.index, self.reason)?;
+        writeln!(f, "  Record:    {:x?}", self.record)?;
+        writeln!(f, "  Reference: {}", self.reference)?;
+        write!(f,   "  Optimized: {}", self.optimized)
+    }
+}
+
+/// Runs a reference predictor and an optimized predictor in lockstep on the
+/// same trace, stopping at the first divergence. 
+///
+/// Both predictors share a single [EvalHistory]. For each conditional 
+/// branch, the predictions [including metadata] must be identical. After 
+/// each record, 'check' is used to compare the internal state of the 
+/// predictors; it returns a description of the reference and optimized 
+/// state when they differ. 
+pub struct LockstepEvaluator<R, O, F> 
+    where R: ConditionalPredictor,
+          O: ConditionalPredictor<Meta = R::Meta>,
+          F: FnMut(&R, &O, &EvalHistory) -> Option<(String, String)>,
+{
+    pub hist: EvalHistory,
+    pub reference: R,
+    pub optimized: O,
+    check: F,
+
+    /// Number of records evaluated so far
+    pub pos: usize,
+}
+impl <R, O, F> LockstepEvaluator<R, O, F> 
+    where R: ConditionalPredictor,
+          O: ConditionalPredictor<Meta = R::Meta>,
+          R::Meta: PartialEq + Debug,
+          F: FnMut(&R, &O, &EvalHistory) -> Option<(String, String)>,
+{
+    pub fn new(reference: R, optimized: O, check: F) -> Self {
+        Self { hist: EvalHistory::new(), reference, optimized, check, pos: 0 }
+    }
+
+    /// Evaluate a single record with both predictors.
+    pub fn step(&mut self, record: &BranchRecord) -> Result<(), Divergence> {
+        let index = self.pos;
+        self.pos += 1;
+        let diverge = |reason: &str, reference: String, optimized: String| {
+            Divergence { 
+                index, record: *record, reason: reason.to_string(), 
+                reference, optimized,
+            }
+        };
+
+        if record.is_conditional() {
+            let r = self.reference.predict_branch(record, &self.hist);
+            let o = self.optimized.predict_branch(record, &self.hist);
+            if r.outcome != o.outcome || r.confidence != o.confidence 
+                || r.meta != o.meta 
+            {
+                return Err(diverge("prediction", 
+                    format!("{:?}", r), format!("{:?}", o)));
+            }
+            self.reference.update_branch(record, &self.hist, &r);
+            self.optimized.update_branch(record, &self.hist, &o);
+        }
+        self.hist.update(record);
+        ConditionalPredictor::update_history(&mut self.reference, &self.hist);
+        ConditionalPredictor::update_history(&mut self.optimized, &self.hist);
+
+        if let Some((r, o)) = (self.check)(&self.reference, &self.optimized,
+            &self.hist) 
+        {
+            return Err(diverge("state", r, o));
+        }
+        Ok(())
+    }
+
+    /// Evaluate a list of records, stopping at the first divergence.
+    pub fn run(&mut self, records: &[BranchRecord]) -> Result<(), Divergence> {
+        for record in records {
+            self.step(record)?;
+        }
+        Ok(())
+    }
+}
+
+/// A [TAGEPredictor] which recomputes the folded global history for each 
+/// tagged component from scratch with [HistoryRegister::fold], instead of
+/// using [FoldedHistoryRegister::update].
+pub struct ReferenceTAGE(pub TAGEPredictor);
+impl ConditionalPredictor for ReferenceTAGE {
+    type Meta = TAGEPrediction;
+    fn predict_branch(&mut self, record: &BranchRecord, hist: &EvalHistory)
+        -> BranchPrediction<TAGEPrediction>
+    {
+        self.0.predict_branch(record, hist)
+    }
+    fn update_branch(&mut self, record: &BranchRecord, hist: &EvalHistory,
+        prediction: &BranchPrediction<TAGEPrediction>)
+    {
+        self.0.update_branch(record, hist, prediction)
+    }
+    fn reset(&mut self) {
+        self.0.reset();
+    }
+    fn capacity(&self) -> Option<PredictorCapacity> {
+        ConditionalPredictor::capacity(&self.0)
+    }
+    fn update_history(&mut self, hist: &EvalHistory) {
+        for comp in self.0.comp.iter_mut() {
+            comp.csr.update_reference(&hist.ghr);
+        }
+    }
+}
+
+/// Compare the folded history registers in two TAGE predictors. 
+pub fn diff_tage_folded_history(r: &ReferenceTAGE, o: &TAGEPredictor, 
+    hist: &EvalHistory) -> Option<(String, String)>
+{
+    let differs = r.0.comp.iter().zip(o.comp.iter())
+        .any(|(x, y)| x.csr.output_usize() != y.csr.output_usize());
+    if !differs {
+        return None;
+    }
+    let dump = |tage: &TAGEPredictor| {
+        let csrs: Vec<String> = tage.comp.iter()
+            .map(|c| format!("{:?}={:03x}", c.cfg.ghr_range, 
+                c.csr.output_usize()))
+            .collect();
+        format!("ghr={} folded=[{}]", hist.ghr, csrs.join(", "))
+    };
+    Some((dump(&r.0), dump(o)))
+}
+
+impl HeapSize for ReferenceTAGE {
+    fn heap_bytes(&self) -> usize { self.0.heap_bytes() }
+    fn heap_usage(&self, name: &str) -> HeapUsage {
+        HeapSize::heap_usage(&self.0, name)
+    }
+}
+
+impl SaveState for ReferenceTAGE {
+    fn save_state(&self, e: &mut Encoder) {
+        SaveState::save_state(&self.0, e)
+    }
+    fn restore_state(&mut self, d: &mut Decoder) -> Option<()> {
+        SaveState::restore_state(&mut self.0, d)
+    }
+}
@@ -0,0 +1,435 @@
+
+use crate::branch::*;
+use crate::eval::*;
+use crate::checkpoint::*;
+use crate::codec::*;
+use crate::heap::*;
+use crate::hugepage::*;
+use crate::predictor::*;
+
+/// What a [BranchFilter] knows about some branch.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum FilterState {
+    /// The branch has not been observed
+    Unseen,
+
+    /// The branch has only been observed with a single outcome
+    Biased(Outcome),
+
+    /// The branch has been observed with both outcomes
+    Mixed,
+}
+
+/// A table of 2^n entries tracking whether the branches at each index have
+/// only been observed with a single outcome.
+///
+/// Entries are not tagged. Branches that alias with a branch in the other
+/// direction are both treated as [FilterState::Mixed].
+pub struct BiasTable {
+    /// Number of index bits
+    pub index_bits: usize,
+
+    /// State of each entry (0: unseen, 1: not-taken, 2: taken, 3: mixed)
+    data: Vec<u8>,
+}
+impl BiasTable {
+    pub fn new(index_bits: usize) -> Self {
+        assert!(index_bits != 0 && index_bits < 32);
+        Self { index_bits, data: huge_vec(1 << index_bits, 0) }
+    }
+
+    /// Forget all branches.
+    pub fn reset(&mut self) { self.data.fill(0) }
+
+    fn get_index(&self, pc: usize) -> usize {
+        let h = (pc as u64).wrapping_mul(0x9e37_79b9_7f4a_7c15);
+        (h >> (64 - self.index_bits)) as usize
+    }
+
+    pub fn lookup(&self, pc: usize) -> FilterState {
+        match self.data[self.get_index(pc)] {
+            0 => FilterState::Unseen,
+            1 => FilterState::Biased(Outcome::N),
+            2 => FilterState::Biased(Outcome::T),
+            _ => FilterState::Mixed,
+        }
+    }
+
+    pub fn update(&mut self, pc: usize, outcome: Outcome) {
+        let idx = self.get_index(pc);
+        let state = 1 + outcome as u8;
+        self.data[idx] = match self.data[idx] {
+            0 => state,
+            x if x == state => state,
+            _ => 3,
+        };
+    }
+}
+impl HeapSize for BiasTable {
+    fn heap_bytes(&self) -> usize { self.data.heap_bytes() }
+}
+impl SaveState for BiasTable {
+    fn save_state(&self, e: &mut Encoder) { e.put_bytes(&self.data) }
+    fn restore_state(&mut self, d: &mut Decoder) -> Option<()> {
+        let data = d.get_bytes()?;
+        if data.len() != self.data.len() || data.iter().any(|x| *x > 3) {
+            return None;
+        }
+        self.data.copy_from_slice(data);
+        Some(())
+    }
+}
+
+/// A pair of Bloom filters recording the branches observed to be taken and
+/// the branches observed to be not-taken, each with 2^n bits and 'k' hash
+/// functions.
+///
+/// A branch found in both sets is [FilterState::Mixed]. False positives
+/// can make an unseen branch appear to be biased [costing a misprediction
+/// the first time it occurs]. Bits are never cleared, so the filter should
+/// be sized so that it doesn't saturate over the length of a trace.
+pub struct BloomFilter {
+    /// Number of index bits
+    pub index_bits: usize,
+
+    /// Number of hash functions
+    pub num_hashes: usize,
+
+    /// Branches observed to be not-taken
+    not_taken: Vec<u64>,
+
+    /// Branches observed to be taken
+    taken: Vec<u64>,
+}
+impl BloomFilter {
+    pub fn new(index_bits: usize, num_hashes: usize) -> Self {
+        assert!(index_bits >= 6 && index_bits < 40);
+        assert!(num_hashes != 0);
+        let words = 1 << (index_bits - 6);
+        Self {
+            index_bits,
+            num_hashes,
+            not_taken: huge_vec(words, 0),
+            taken: huge_vec(words, 0),
+        }
+    }
+
+    /// Forget all branches.
+    pub fn reset(&mut self) {
+        self.not_taken.fill(0);
+        self.taken.fill(0);
+    }
+
+    /// Return the bit indexes for some branch [with double hashing].
+    fn get_indexes(&self, pc: usize) -> impl Iterator<Item=usize> {
+        let h1 = (pc as u64).wrapping_mul(0x9e37_79b9_7f4a_7c15);
+        let h2 = (h1 ^ (h1 >> 31)).wrapping_mul(0xbf58_476d_1ce4_e5b9) | 1;
+        let mask = (1u64 << self.index_bits) - 1;
+        (0..self.num_hashes as u64).map(move |i| {
+            ((h1 >> 24).wrapping_add(i.wrapping_mul(h2)) & mask) as usize
+        })
+    }
+
+    fn contains(set: &[u64], mut idxs: impl Iterator<Item=usize>) -> bool {
+        idxs.all(|idx| set[idx / 64] & (1 << (idx % 64)) != 0)
+    }
+
+    pub fn lookup(&self, pc: usize) -> FilterState {
+        let t = Self::contains(&self.taken, self.get_indexes(pc));
+        let n = Self::contains(&self.not_taken, self.get_indexes(pc));
+        match (t, n) {
+            (false, false) => FilterState::Unseen,
+            (true, false) => FilterState::Biased(Outcome::T),
+            (false, true) => FilterState::Biased(Outcome::N),
+            (true, true) => FilterState::Mixed,
+        }
+    }
+
+    pub fn update(&mut self, pc: usize, outcome: Outcome) {
+        let idxs = self.get_indexes(pc);
+        let set = match outcome {
+            Outcome::T => &mut self.taken,
+            Outcome::N => &mut self.not_taken,
+        };
+        for idx in idxs {
+            set[idx / 64] |= 1 << (idx % 64);
+        }
+    }
+
+    /// Return the fraction of bits set in each filter [not-taken, taken].
+    pub fn occupancy(&self) -> (f64, f64) {
+        let bits = (1u64 << self.index_bits) as f64;
+        let count = |set: &[u64]| {
+            set.iter().map(|w| w.count_ones() as u64).sum::<u64>() as f64
+        };
+        (count(&self.not_taken) / bits, count(&self.taken) / bits)
+    }
+}
+impl HeapSize for BloomFilter {
+    fn heap_bytes(&self) -> usize {
+        self.not_taken.heap_bytes() + self.taken.heap_bytes()
+    }
+}
+impl SaveState for BloomFilter {
+    fn save_state(&self, e: &mut Encoder) {
+        e.put_slice(&self.not_taken);
+        e.put_slice(&self.taken);
+    }
+
+    fn restore_state(&mut self, d: &mut Decoder) -> Option<()> {
+        let not_taken: Vec<u64> = d.get_vec()?;
+        let taken: Vec<u64> = d.get_vec()?;
+        if not_taken.len() != self.not_taken.len()
+        || taken.len() != self.taken.len()
+        {
+            return None;
+        }
+        self.not_taken.copy_from_slice(&not_taken);
+        self.taken.copy_from_slice(&taken);
+        Some(())
+    }
+}
+
+/// A filter that predicts [and keeps track of] biased branches in front of
+/// some other predictor (see [FilteredPredictor]).
+pub enum BranchFilter {
+    Bias(BiasTable),
+    Bloom(BloomFilter),
+}
+impl BranchFilter {
+    #[inline]
+    pub fn lookup(&self, pc: usize) -> FilterState {
+        match self {
+            Self::Bias(f) => f.lookup(pc),
+            Self::Bloom(f) => f.lookup(pc),
+        }
+    }
+
+    #[inline]
+    pub fn update(&mut self, pc: usize, outcome: Outcome) {
+        match self {
+            Self::Bias(f) => f.update(pc, outcome),
+            Self::Bloom(f) => f.update(pc, outcome),
+        }
+    }
+
+    /// Forget all branches.
+    pub fn reset(&mut self) {
+        match self {
+            Self::Bias(f) => f.reset(),
+            Self::Bloom(f) => f.reset(),
+        }
+    }
+}
+impl HeapSize for BranchFilter {
+    fn heap_bytes(&self) -> usize {
+        match self {
+            Self::Bias(f) => f.heap_bytes(),
+            Self::Bloom(f) => f.heap_bytes(),
+        }
+    }
+}
+impl SaveState for BranchFilter {
+    fn save_state(&self, e: &mut Encoder) {
+        match self {
+            Self::Bias(f) => f.save_state(e),
+            Self::Bloom(f) => f.save_state(e),
+        }
+    }
+
+    fn restore_state(&mut self, d: &mut Decoder) -> Option<()> {
+        match self {
+            Self::Bias(f) => f.restore_state(d),
+            Self::Bloom(f) => f.restore_state(d),
+        }
+    }
+}
+
+/// A description of some [BranchFilter] configuration.
+///
+/// - `bias:<n>`: a [BiasTable] with 2^n entries
+/// - `bloom:<n>[:<k>]`: a [BloomFilter] with 2^n bits in each set and 'k'
+///   hash functions (the default is 2)
+#[derive(Clone, Copy, Debug, PartialEq, Eq, Hash)]
+pub enum FilterSpec {
+    Bias(usize),
+    Bloom(usize, usize),
+}
+impl FilterSpec {
+    pub fn parse(s: &str) -> Result<Self, String> {
+        let mut fields = s.split(':');
+        let kind = fields.next().unwrap();
+        let args: Vec<usize> = fields.map(|f| f.parse::<usize>())
+            .collect::<Result<_, _>>()
+            .map_err(|e| format!("invalid filter '{}': {}", s, e))?;
+
+        let res = match (kind, args.as_slice()) {
+            ("bias", [n]) if (1..32).contains(n) => Self::Bias(*n),
+            ("bloom", [n]) if (6..40).contains(n) => Self::Bloom(*n, 2),
+            ("bloom", [n, k]) if (6..40).contains(n) && *k != 0 => {
+                Self::Bloom(*n, *k)
+            },
+            _ => return Err(format!("invalid filter '{}'", s)),
+        };
+        Ok(res)
+    }
+
+    /// Create a new filter with 1/'num_parts' of the entries in this
+    /// configuration (see [PredictorSpec::build_partition]).
+    pub fn build_partition(&self, num_parts: usize) 
+        -> Result<BranchFilter, String> 
+    {
+        let shift = num_parts.ilog2() as usize;
+        let min_bits = match self {
+            Self::Bias(_) => 1,
+            Self::Bloom(..) => 6,
+        };
+        let (Self::Bias(n) | Self::Bloom(n, _)) = self;
+        if *n < min_bits + shift {
+            return Err(format!("{} cannot be divided into {} parts", 
+                self, num_parts));
+        }
+        Ok(match self {
+            Self::Bias(n) => BranchFilter::Bias(BiasTable::new(n - shift)),
+            Self::Bloom(n, k) => {
+                BranchFilter::Bloom(BloomFilter::new(n - shift, *k))
+            },
+        })
+    }
+
+    pub fn build(&self) -> BranchFilter {
+        self.build_partition(1).unwrap()
+    }
+}
+impl std::fmt::Display for FilterSpec {
+    fn fmt(&self, f: &mut std::fmt::Formatter) -> std::fmt::Result {
+        match self {
+            Self::Bias(n) => write!(f, "bias:{}", n),
+            Self::Bloom(n, k) => write!(f, "bloom:{}:{}", n, k),
+        }
+    }
+}
+
+/// Statistics collected by a [FilteredPredictor].
+#[derive(Clone, Debug, Default)]
+pub struct FilterStats {
+    /// Conditional branches predicted by the filter
+    pub filtered: usize,
+
+    /// Mispredictions made by the filter
+    pub filtered_miss: usize,
+
+    /// Conditional branches passed to the underlying predictor
+    pub forwarded: usize,
+}
+impl FilterStats {
+    /// Return the fraction of conditional branches predicted by the filter.
+    pub fn filtered_rate(&self) -> f64 {
+        self.filtered as f64 / (self.filtered + self.forwarded).max(1) as f64
+    }
+}
+impl Codec for FilterStats {
+    fn encode(&self, e: &mut Encoder) {
+        e.put_usize(self.filtered);
+        e.put_usize(self.filtered_miss);
+        e.put_usize(self.forwarded);
+    }
+
+    fn decode(d: &mut Decoder) -> Option<Self> {
+        Some(Self {
+            filtered: d.get_usize()?,
+            filtered_miss: d.get_usize()?,
+            forwarded: d.get_usize()?,
+        })
+    }
+}
+
+/// A [BranchFilter] in front of some other predictor.
+///
+/// Branches that the filter has only observed with a single outcome are
+/// predicted by the filter, and never reach the underlying predictor.
+/// Branches observed with both outcomes [and branches observed for the
+/// first time] are passed to the underlying predictor. Once the filter
+/// mispredicts a branch, the branch is passed to the underlying predictor
+/// from then on.
+///
+/// NOTE: The first occurrence of every branch reaches the underlying
+/// predictor, since the filter can't know that it's biased yet. A TAGE
+/// predictor may allocate entries for it [which are later left to age
+/// out], so the filter saves less capacity than the number of filtered
+/// branches suggests (see [EvalPredictor::capacity]).
+///
+/// Filtered branches still update the shared history, so the underlying
+/// predictor always sees the same global history.
+pub struct FilteredPredictor<P: ?Sized> {
+    pub filter: BranchFilter,
+    pub stat: FilterStats,
+    pub inner: Box<P>,
+}
+impl <P: EvalPredictor + ?Sized> FilteredPredictor<P> {
+    pub fn new(filter: BranchFilter, inner: Box<P>) -> Self {
+        Self { filter, stat: FilterStats::default(), inner }
+    }
+
+    /// Returns 'true' if some branch is currently predicted by the filter.
+    pub fn is_filtered(&self, pc: usize) -> bool {
+        matches!(self.filter.lookup(pc), FilterState::Biased(_))
+    }
+}
+impl <P: EvalPredictor + ?Sized> EvalPredictor for FilteredPredictor<P> {
+    fn step(&mut self, record: &BranchRecord, hist: &EvalHistory)
+        -> (Outcome, Confidence)
+    {
+        match self.filter.lookup(record.pc) {
+            FilterState::Biased(outcome) => {
+                self.stat.filtered += 1;
+                if outcome != record.outcome {
+                    self.stat.filtered_miss += 1;
+                    self.filter.update(record.pc, record.outcome);
+                }
+                (outcome, Confidence(Confidence::MAX))
+            },
+            state => {
+                self.stat.forwarded += 1;
+                if state == FilterState::Unseen {
+                    self.filter.update(record.pc, record.outcome);
+                }
+                self.inner.step(record, hist)
+            },
+        }
+    }
+
+    fn update_history(&mut self, hist: &EvalHistory) {
+        self.inner.update_history(hist);
+    }
+
+    fn reset(&mut self) {
+        self.stat = FilterStats::default();
+        self.filter.reset();
+        self.inner.reset();
+    }
+
+    fn capacity(&self) -> Option<PredictorCapacity> {
+        self.inner.capacity()
+    }
+
+    fn heap_usage(&self, name: &str) -> HeapUsage {
+        HeapUsage::from_children(name, vec![
+            self.filter.heap_usage("filter"),
+            self.inner.heap_usage("predictor"),
+        ])
+    }
+
+    fn save_state(&self, e: &mut Encoder) {
+        self.stat.encode(e);
+        self.filter.save_state(e);
+        self.inner.save_state(e);
+    }
+
+    fn restore_state(&mut self, d: &mut Decoder) -> Option<()> {
+        self.stat = FilterStats::decode(d)?;
+        self.filter.restore_state(d)?;
+        self.inner.restore_state(d)
+    }
+}
+
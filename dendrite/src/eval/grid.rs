@@ -0,0 +1,144 @@
+
+use std::collections::*;
+use std::fs::OpenOptions;
+use std::sync::Mutex;
+use crate::eval::*;
+use crate::pool::*;
+use crate::stats::*;
+use crate::trace::*;
+
+/// A single job in a [GridEvaluator]: one predictor evaluated on one trace.
+#[derive(Clone, Debug, PartialEq, Eq, Hash)]
+pub struct GridJob {
+    /// Path to a trace file
+    pub trace: String,
+
+    /// Predictor configuration
+    pub spec: PredictorSpec,
+}
+impl GridJob {
+    /// Return the name used to identify results for this job.
+    pub fn key(&self) -> String {
+        format!("{}\t{}", self.trace, self.spec)
+    }
+}
+
+/// An append-only file of [ResultTable]s from completed jobs, named by
+/// [GridJob::key].
+pub struct ResultStore {
+    writer: Mutex<ResultWriter>,
+    completed: HashSet<String>,
+
+    /// Jobs that failed in this run, along with the error [these are not
+    /// written to the file, so they are retried by the next run]
+    failed: Mutex<Vec<(String, String)>>,
+}
+impl ResultStore {
+    /// Open a store [creating it if necessary], and read the list of 
+    /// completed jobs. If the last result was only partially written, it 
+    /// is discarded. 
+    pub fn open(path: &str) -> std::io::Result<Self> {
+        let mut completed = HashSet::new();
+        if std::path::Path::new(path).exists() {
+            let mut reader = ResultReader::open(path)?;
+            while let Some(Ok(table)) = reader.next() {
+                completed.insert(table.name);
+            }
+            let f = OpenOptions::new().write(true).open(path)?;
+            f.set_len(reader.valid_len())?;
+        }
+        Ok(Self {
+            writer: Mutex::new(ResultWriter::append(path)?),
+            completed,
+            failed: Mutex::new(Vec::new()),
+        })
+    }
+
+    /// Returns 'true' if results for some job have already been recorded.
+    pub fn is_completed(&self, job: &GridJob) -> bool {
+        self.completed.contains(&job.key())
+    }
+
+    pub fn num_completed(&self) -> usize { self.completed.len() }
+
+    /// Record the results for some job.
+    pub fn write(&self, table: &ResultTable) -> std::io::Result<()> {
+        self.writer.lock().unwrap().write(table)
+    }
+
+    /// Record that some job failed.
+    pub fn write_failed(&self, job: &GridJob, err: impl ToString) {
+        self.failed.lock().unwrap().push((job.key(), err.to_string()));
+    }
+
+    /// Return the jobs that failed in this run [by key], and the errors.
+    pub fn failed(&self) -> Vec<(String, String)> {
+        self.failed.lock().unwrap().clone()
+    }
+}
+
+/// Evaluates every combination of a list of traces and a list of predictor
+/// configurations on a [WorkPool].
+///
+/// Loaded traces are shared by all jobs through a [TraceCache], which 
+/// bounds the amount of memory used by resident traces. Results are written
+/// to a [ResultStore] as soon as each job completes, and jobs that already 
+/// have results in the store are skipped. 
+pub struct GridEvaluator {
+    pub pool: WorkPool,
+    pub cache: TraceCache,
+    pub store: ResultStore,
+
+    /// Record per-branch results for each job
+    pub per_branch: bool,
+}
+impl GridEvaluator {
+    pub fn new(pool: WorkPool, cache: TraceCache, store: ResultStore) -> Self {
+        Self { pool, cache, store, per_branch: false }
+    }
+
+    /// Expand a list of traces and configurations into a list of jobs.
+    ///
+    /// Jobs are ordered by trace, so that jobs sharing the same trace are 
+    /// likely to run at the same time. 
+    pub fn expand(traces: &[String], specs: &[PredictorSpec]) -> Vec<GridJob> {
+        let mut res = Vec::new();
+        for trace in traces {
+            for spec in specs {
+                res.push(GridJob { trace: trace.clone(), spec: spec.clone() });
+            }
+        }
+        res
+    }
+
+    /// Run a single job and return the results.
+    /// Returns an error if the trace can't be loaded.
+    pub fn run_job(&self, job: &GridJob) -> std::io::Result<ResultTable> {
+        let trace = self.cache.get(&job.trace)?;
+        let mut eval = MultiEvaluator::from_specs(&[job.spec.clone()]);
+        eval.per_branch = self.per_branch;
+        eval.run(trace.as_slice());
+        Ok(ResultTable::from_branch_stats(job.key(), &eval.slots[0].stats))
+    }
+
+    /// Run all jobs that haven't already been completed. 
+    /// Returns the number of jobs that were run. 
+    ///
+    /// Jobs that fail are recorded with [ResultStore::write_failed] and
+    /// don't stop the other jobs. 
+    pub fn run(&self, jobs: Vec<GridJob>) -> usize {
+        let pending: Vec<GridJob> = jobs.into_iter()
+            .filter(|job| !self.store.is_completed(job))
+            .collect();
+        let num_pending = pending.len();
+        self.pool.map(pending, |_, job| {
+            let res = self.run_job(&job)
+                .and_then(|table| self.store.write(&table));
+            if let Err(e) = res {
+                self.store.write_failed(&job, e);
+            }
+        });
+        num_pending
+    }
+}
+
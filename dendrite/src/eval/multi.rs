@@ -0,0 +1,151 @@
+
+use crate::branch::*;
+use crate::eval::*;
+use crate::checkpoint::*;
+use crate::codec::*;
+use crate::heap::*;
+use crate::history::*;
+use crate::stats::*;
+
+/// A predictor being evaluated by a [MultiEvaluator].
+pub struct EvalSlot {
+    /// Name identifying this predictor
+    pub name: String,
+
+    /// The predictor
+    pub predictor: Box<dyn EvalPredictor + Send>,
+
+    /// Statistics collected for this predictor
+    pub stats: BranchStats,
+}
+impl EvalSlot {
+    /// Return a breakdown of the memory used by the predictor and the 
+    /// statistics collected for it.
+    pub fn heap_usage(&self) -> HeapUsage {
+        HeapUsage::from_children(&self.name, vec![
+            self.predictor.heap_usage("predictor"),
+            self.stats.heap_usage("stats"),
+        ])
+    }
+}
+
+/// Evaluates many predictors with a single pass over a trace.
+///
+/// Each record is read once, and the shared history registers are only
+/// updated once per record. Each conditional branch is passed to every
+/// predictor in turn.
+pub struct MultiEvaluator {
+    /// History registers shared by all predictors
+    pub hist: EvalHistory,
+
+    /// The list of predictors
+    pub slots: Vec<EvalSlot>,
+
+    /// Collect per-branch statistics for each predictor
+    pub per_branch: bool,
+}
+impl MultiEvaluator {
+    pub fn new() -> Self {
+        Self {
+            hist: EvalHistory::new(),
+            slots: Vec::new(),
+            per_branch: false,
+        }
+    }
+
+    /// Create an evaluator from a list of [PredictorSpec].
+    pub fn from_specs(specs: &[PredictorSpec]) -> Self {
+        let mut res = Self::new();
+        for spec in specs {
+            res.add(spec.to_string(), spec.build());
+        }
+        res
+    }
+
+    /// Add a predictor to the evaluation.
+    pub fn add(&mut self, name: impl ToString,
+        predictor: Box<dyn EvalPredictor + Send>)
+    {
+        self.slots.push(EvalSlot {
+            name: name.to_string(),
+            predictor,
+            stats: BranchStats::new(),
+        });
+    }
+
+    /// Evaluate a single record.
+    pub fn step(&mut self, record: &BranchRecord) {
+        self.step_folded(record, fold_pc_12b(record.pc));
+    }
+
+    /// Evaluate a single record, given the program counter folded with 
+    /// [fold_pc_12b].
+    pub fn step_folded(&mut self, record: &BranchRecord, pc_bits: usize) {
+        if record.is_conditional() {
+            for slot in self.slots.iter_mut() {
+                let (outcome, conf) = slot.predictor.step(record, &self.hist);
+                slot.stats.update_global(record, outcome);
+                slot.stats.update_confidence(record, outcome, conf);
+                if self.per_branch {
+                    slot.stats.update_per_branch(record, outcome);
+                }
+            }
+        }
+        self.hist.update_folded(record, pc_bits);
+        for slot in self.slots.iter_mut() {
+            slot.predictor.update_history(&self.hist);
+        }
+    }
+
+    /// Evaluate a list of records.
+    pub fn run(&mut self, records: &[BranchRecord]) {
+        for record in records {
+            self.step(record);
+        }
+    }
+
+    /// Update the predictors and history with a list of records without 
+    /// collecting any statistics.
+    pub fn warm_up(&mut self, records: &[BranchRecord]) {
+        for record in records {
+            if record.is_conditional() {
+                for slot in self.slots.iter_mut() {
+                    slot.predictor.step(record, &self.hist);
+                }
+            }
+            self.hist.update(record);
+            for slot in self.slots.iter_mut() {
+                slot.predictor.update_history(&self.hist);
+            }
+        }
+    }
+}
+
+/// Predictors are restored in the order they were added, so the evaluator
+/// must be created with the same list of predictors.
+impl SaveState for MultiEvaluator {
+    fn save_state(&self, e: &mut Encoder) {
+        self.hist.save_state(e);
+        e.put_usize(self.slots.len());
+        for slot in self.slots.iter() {
+            e.put_str(&slot.name);
+            slot.predictor.save_state(e);
+            slot.stats.encode(e);
+        }
+    }
+
+    fn restore_state(&mut self, d: &mut Decoder) -> Option<()> {
+        self.hist.restore_state(d)?;
+        if d.get_usize()? != self.slots.len() {
+            return None;
+        }
+        for slot in self.slots.iter_mut() {
+            if d.get_str()? != slot.name {
+                return None;
+            }
+            slot.predictor.restore_state(d)?;
+            slot.stats = BranchStats::decode(d)?;
+        }
+        Some(())
+    }
+}
@@ -0,0 +1,242 @@
+
+use crate::branch::*;
+use crate::eval::*;
+use crate::history::*;
+use crate::ring::*;
+use crate::trace::*;
+
+/// A batch of decoded records passed between threads.
+pub struct RecordBatch {
+    pub records: Vec<BranchRecord>,
+
+    /// Program counter for each record, folded with [fold_pc_12b]
+    pub pc_bits: Vec<usize>,
+}
+impl RecordBatch {
+    pub fn with_capacity(size: usize) -> Self {
+        Self {
+            records: Vec::with_capacity(size),
+            pc_bits: Vec::with_capacity(size),
+        }
+    }
+
+    /// Fill the batch with the next block from a trace, keeping only the 
+    /// records that pass 'filter'. Returns the number of records read from
+    /// the trace [zero at the end of the trace].
+    pub fn fill(&mut self, reader: &mut TraceReader, size: usize,
+        filter: Option<fn(&BranchRecord) -> bool>) -> std::io::Result<usize>
+    {
+        let num_read = reader.read_block(&mut self.records, size)?;
+        if let Some(filter) = filter {
+            self.records.retain(filter);
+        }
+        self.pc_bits.clear();
+        self.pc_bits.extend(self.records.iter().map(|r| fold_pc_12b(r.pc)));
+        Ok(num_read)
+    }
+
+    /// Evaluate all records in the batch. 
+    /// Returns the number of records evaluated.
+    pub fn run(&self, eval: &mut MultiEvaluator) -> usize {
+        for (record, pc_bits) in self.records.iter().zip(self.pc_bits.iter()) {
+            eval.step_folded(record, *pc_bits);
+        }
+        self.records.len()
+    }
+}
+
+/// Summary of a pipelined evaluation.
+#[derive(Clone, Copy, Debug, Default)]
+pub struct PipelineStats {
+    /// Number of records read from the trace
+    pub num_records: usize,
+
+    /// Number of invalid records skipped
+    pub num_invalid: usize,
+
+    /// Number of records passed to the predictors
+    pub num_evaluated: usize,
+
+    /// Number of batches passed to the predictors
+    pub num_batches: usize,
+}
+
+/// Runs a [MultiEvaluator] on a trace file using two threads.
+///
+/// A producer thread reads, validates, and filters records from the trace
+/// and precomputes the folded program counter used for path history. The
+/// evaluator runs on the calling thread. Batches are passed between them 
+/// with a [SpscRing], so no memory is allocated after startup.
+pub struct PipelinedEvaluator {
+    pub eval: MultiEvaluator,
+
+    /// Ring of preallocated batches
+    ring: SpscRing<RecordBatch>,
+
+    /// Number of records in each batch
+    pub batch_size: usize,
+
+    /// Optional filter applied to records before evaluation
+    pub filter: Option<fn(&BranchRecord) -> bool>,
+}
+impl PipelinedEvaluator {
+    pub fn new(eval: MultiEvaluator, num_batches: usize, batch_size: usize)
+        -> Self
+    {
+        Self {
+            eval,
+            ring: SpscRing::new(num_batches, 
+                || RecordBatch::with_capacity(batch_size)),
+            batch_size,
+            filter: None,
+        }
+    }
+
+    /// Evaluate all records in a trace file.
+    ///
+    /// Returns an error if the trace cannot be read, or if it ends with a 
+    /// partial record [in which case all preceding records have already 
+    /// been evaluated].
+    pub fn run_file(&mut self, path: &str) -> std::io::Result<PipelineStats> {
+        let mut reader = TraceReader::open(path)?;
+        let batch_size = self.batch_size;
+        let filter = self.filter;
+        let eval = &mut self.eval;
+        let (mut producer, consumer) = self.ring.split();
+
+        let mut stats = PipelineStats::default();
+        let res = std::thread::scope(|s| {
+            // The decoder stops early if the consumer is dropped [ie. when
+            // a predictor panics], so the scope doesn't wait forever.
+            let decoder = s.spawn(move || {
+                loop {
+                    let res = producer.write(|batch| {
+                        batch.fill(&mut reader, batch_size, filter)
+                    });
+                    match res {
+                        None | Some(Ok(0)) => break,
+                        Some(Ok(_)) => {},
+                        Some(Err(e)) => return Err(e),
+                    }
+                }
+                Ok(reader)
+            });
+
+            // Move the consumer into the scope, so that it's dropped [and
+            // the decoder is released] while unwinding
+            let mut consumer = consumer;
+            while let Some(n) = consumer.read(|batch| batch.run(eval)) {
+                stats.num_evaluated += n;
+                stats.num_batches += (n != 0) as usize;
+            }
+            decoder.join().unwrap()
+        });
+
+        let reader = res?;
+        stats.num_records = reader.num_records;
+        stats.num_invalid = reader.num_invalid;
+        Ok(stats)
+    }
+}
+
+/// Runs many predictors on a trace file, with one thread decoding the trace
+/// and many threads evaluating predictors.
+///
+/// Predictors are divided between worker threads, each with its own 
+/// [MultiEvaluator]. Batches are shared by all workers through a 
+/// [BroadcastRing], so the trace is only read and decoded once. 
+pub struct BroadcastEvaluator {
+    /// One evaluator for each worker thread
+    pub workers: Vec<MultiEvaluator>,
+
+    /// Ring of preallocated batches
+    ring: BroadcastRing<RecordBatch>,
+
+    /// Number of records in each batch
+    pub batch_size: usize,
+
+    /// Optional filter applied to records before evaluation
+    pub filter: Option<fn(&BranchRecord) -> bool>,
+}
+impl BroadcastEvaluator {
+    /// Divide a list of predictors between 'num_workers' threads.
+    pub fn from_specs(specs: &[PredictorSpec], num_workers: usize, 
+        num_batches: usize, batch_size: usize) -> Self
+    {
+        let num_workers = num_workers.min(specs.len()).max(1);
+        let mut workers: Vec<MultiEvaluator> = (0..num_workers)
+            .map(|_| MultiEvaluator::new())
+            .collect();
+        for (idx, spec) in specs.iter().enumerate() {
+            workers[idx % num_workers].add(spec.to_string(), spec.build());
+        }
+        Self {
+            workers,
+            ring: BroadcastRing::new(num_batches, 
+                || RecordBatch::with_capacity(batch_size)),
+            batch_size,
+            filter: None,
+        }
+    }
+
+    /// Return all predictors in the order they were added.
+    pub fn slots(&self) -> Vec<&EvalSlot> {
+        let num_workers = self.workers.len();
+        let num_slots = self.workers.iter().map(|w| w.slots.len()).sum();
+        (0..num_slots).map(|idx| {
+            &self.workers[idx % num_workers].slots[idx / num_workers]
+        }).collect()
+    }
+
+    /// Evaluate all records in a trace file.
+    pub fn run_file(&mut self, path: &str) -> std::io::Result<PipelineStats> {
+        let mut reader = TraceReader::open(path)?;
+        let batch_size = self.batch_size;
+        let filter = self.filter;
+        let workers = &mut self.workers;
+        let (mut producer, consumers) = self.ring.split(workers.len());
+
+        let mut stats = PipelineStats::default();
+        let res = std::thread::scope(|s| {
+            // The decoder stops early if any worker panics [dropping its
+            // consumer], so the scope doesn't wait forever.
+            let decoder = s.spawn(move || {
+                loop {
+                    let res = producer.write(|batch| {
+                        batch.fill(&mut reader, batch_size, filter)
+                    });
+                    match res {
+                        None | Some(Ok(0)) => break,
+                        Some(Ok(_)) => {},
+                        Some(Err(e)) => return Err(e),
+                    }
+                }
+                Ok(reader)
+            });
+
+            let handles: Vec<_> = workers.iter_mut().zip(consumers)
+                .map(|(eval, mut consumer)| s.spawn(move || {
+                    let mut res = PipelineStats::default();
+                    while let Some(n) = consumer.read(|b| b.run(eval)) {
+                        res.num_evaluated += n;
+                        res.num_batches += (n != 0) as usize;
+                    }
+                    res
+                })).collect();
+
+            // Every worker sees the same batches
+            for handle in handles {
+                let res = handle.join().unwrap();
+                stats.num_evaluated = res.num_evaluated;
+                stats.num_batches = res.num_batches;
+            }
+            decoder.join().unwrap()
+        });
+
+        let reader = res?;
+        stats.num_records = reader.num_records;
+        stats.num_invalid = reader.num_invalid;
+        Ok(stats)
+    }
+}
+
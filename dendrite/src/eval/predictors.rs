@@ -0,0 +1,170 @@
+//! Implementations of [ConditionalPredictor] for the predictors in this 
+//! crate.
+
+use crate::branch::*;
+use crate::eval::*;
+use crate::predictor::*;
+use crate::predictor::gshare::*;
+use crate::predictor::pht::*;
+use crate::predictor::simple::*;
+
+impl ConditionalPredictor for TakenPredictor {
+    type Meta = ();
+    fn predict_branch(&mut self, _record: &BranchRecord, _hist: &EvalHistory)
+        -> BranchPrediction<()>
+    {
+        BranchPrediction { 
+            outcome: self.predict(), 
+            confidence: Confidence(Confidence::MAX),
+            meta: (),
+        }
+    }
+    fn update_branch(&mut self, _record: &BranchRecord, _hist: &EvalHistory,
+        _prediction: &BranchPrediction<()>) {}
+    fn reset(&mut self) {}
+}
+
+impl ConditionalPredictor for NotTakenPredictor {
+    type Meta = ();
+    fn predict_branch(&mut self, _record: &BranchRecord, _hist: &EvalHistory)
+        -> BranchPrediction<()>
+    {
+        BranchPrediction { 
+            outcome: self.predict(), 
+            confidence: Confidence(Confidence::MAX),
+            meta: (),
+        }
+    }
+    fn update_branch(&mut self, _record: &BranchRecord, _hist: &EvalHistory,
+        _prediction: &BranchPrediction<()>) {}
+    fn reset(&mut self) {}
+}
+
+impl ConditionalPredictor for RandomPredictor {
+    type Meta = ();
+    fn predict_branch(&mut self, _record: &BranchRecord, _hist: &EvalHistory)
+        -> BranchPrediction<()>
+    {
+        BranchPrediction { 
+            outcome: self.predict(), 
+            confidence: Confidence(0),
+            meta: (),
+        }
+    }
+    fn update_branch(&mut self, _record: &BranchRecord, _hist: &EvalHistory,
+        _prediction: &BranchPrediction<()>) {}
+    fn reset(&mut self) {}
+}
+
+/// The metadata is the index of the counter used for the prediction.
+impl ConditionalPredictor for SimplePHT {
+    type Meta = usize;
+    fn predict_branch(&mut self, record: &BranchRecord, _hist: &EvalHistory)
+        -> BranchPrediction<usize>
+    {
+        let idx = self.get_index(record.pc);
+        let entry = self.get_entry(idx);
+        BranchPrediction {
+            outcome: entry.predict(),
+            confidence: entry.confidence(),
+            meta: idx,
+        }
+    }
+    fn update_branch(&mut self, record: &BranchRecord, _hist: &EvalHistory,
+        prediction: &BranchPrediction<usize>)
+    {
+        self.get_entry_mut(prediction.meta).update(record.outcome);
+    }
+    fn reset(&mut self) {
+        SimplePHT::reset(self);
+    }
+}
+
+/// The metadata is the index of the counter used for the prediction.
+impl ConditionalPredictor for GsharePredictor {
+    type Meta = usize;
+    fn predict_branch(&mut self, record: &BranchRecord, hist: &EvalHistory)
+        -> BranchPrediction<usize>
+    {
+        let idx = self.get_index((record.pc, &hist.ghr));
+        let entry = self.get_entry(idx);
+        BranchPrediction {
+            outcome: entry.predict(),
+            confidence: entry.confidence(),
+            meta: idx,
+        }
+    }
+    fn update_branch(&mut self, record: &BranchRecord, _hist: &EvalHistory,
+        prediction: &BranchPrediction<usize>)
+    {
+        self.get_entry_mut(prediction.meta).update(record.outcome);
+    }
+    fn reset(&mut self) {
+        GsharePredictor::reset(self);
+    }
+}
+
+/// The metadata is the index of the perceptron, the input vector, and the 
+/// output value used for the prediction.
+impl <const L: usize> ConditionalPredictor for PerceptronTable<L> {
+    type Meta = (usize, [i8; L], i8);
+    fn predict_branch(&mut self, record: &BranchRecord, hist: &EvalHistory)
+        -> BranchPrediction<Self::Meta>
+    {
+        let input = Self::input(&hist.ghr);
+        let idx = self.get_index(record.pc);
+        let (output, outcome) = self.get_entry(idx).output(&input);
+        BranchPrediction {
+            outcome,
+            confidence: Perceptron::<L>::confidence(output),
+            meta: (idx, input, output),
+        }
+    }
+    fn update_branch(&mut self, record: &BranchRecord, _hist: &EvalHistory,
+        prediction: &BranchPrediction<Self::Meta>)
+    {
+        let (idx, input, output) = &prediction.meta;
+        self.get_entry_mut(*idx).train_output(input, *output, record.outcome);
+    }
+    fn reset(&mut self) {
+        PerceptronTable::<L>::reset(self);
+    }
+}
+
+/// The metadata is the full [TAGEPrediction].
+impl ConditionalPredictor for TAGEPredictor {
+    type Meta = TAGEPrediction;
+    fn predict_branch(&mut self, record: &BranchRecord, hist: &EvalHistory)
+        -> BranchPrediction<TAGEPrediction>
+    {
+        let inputs = TAGEInputs { pc: record.pc, phr: &hist.phr };
+        let p = self.predict(inputs);
+        BranchPrediction { 
+            outcome: p.outcome, 
+            confidence: p.confidence, 
+            meta: p,
+        }
+    }
+    fn update_branch(&mut self, record: &BranchRecord, hist: &EvalHistory,
+        prediction: &BranchPrediction<TAGEPrediction>)
+    {
+        let inputs = TAGEInputs { pc: record.pc, phr: &hist.phr };
+        self.update(inputs, prediction.meta, record.outcome);
+    }
+    fn reset(&mut self) {
+        TAGEPredictor::reset(self);
+    }
+    fn capacity(&self) -> Option<PredictorCapacity> {
+        Some(PredictorCapacity {
+            allocs: self.stat.alcs,
+            failed_allocs: self.stat.failed_alcs,
+            used: self.comp.iter().map(|c| c.num_valid_entries()).sum(),
+            entries: self.comp.iter().map(|c| c.data.len()).sum(),
+        })
+    }
+
+    fn update_history(&mut self, hist: &EvalHistory) {
+        TAGEPredictor::update_history(self, &hist.ghr);
+    }
+}
+
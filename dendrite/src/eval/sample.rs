@@ -0,0 +1,253 @@
+
+use std::ops::Range;
+use crate::branch::*;
+use crate::eval::*;
+use crate::predictor::XorShift64;
+use crate::stats::*;
+
+/// Strategy used to place the windows measured by a [SampledEvaluator].
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum SampleStrategy {
+    /// Windows are evenly spaced throughout the trace
+    Systematic,
+
+    /// One window is placed at a random offset in each of the evenly-sized
+    /// parts of the trace [with the given seed]
+    Random(u64),
+}
+
+/// A window in the trace evaluated by a [SampledEvaluator].
+#[derive(Clone, Debug, PartialEq, Eq)]
+pub struct Sample {
+    /// Records used to warm up the predictor [without measuring]
+    pub warmup: Range<usize>,
+
+    /// Records being measured
+    pub measure: Range<usize>,
+}
+impl Sample {
+    /// Place 'num_samples' windows in a trace with 'len' records, each with
+    /// 'warmup' records followed by 'measure' records.
+    ///
+    /// The trace is divided into 'num_samples' parts of equal size, and
+    /// each window is placed in a different part. Returns an error if the
+    /// windows don't fit in the trace [naming the most that would fit].
+    pub fn place(len: usize, num_samples: usize, warmup: usize,
+        measure: usize, strategy: SampleStrategy) -> Result<Vec<Self>, String>
+    {
+        assert!(num_samples != 0 && measure != 0);
+        let part_len = len / num_samples;
+        let unit = warmup + measure;
+        if unit > part_len {
+            let max_samples = len / unit;
+            return Err(if max_samples == 0 {
+                format!("a single sample of {} records does not fit in {} \
+                    records", unit, len)
+            } else {
+                format!("{} samples of {} records do not fit in {} records \
+                    (use --samples {} or fewer)", num_samples, unit, len, 
+                    max_samples)
+            });
+        }
+
+        let slack = part_len - unit;
+        let mut rng = match strategy {
+            SampleStrategy::Systematic => None,
+            SampleStrategy::Random(seed) => Some(XorShift64::new(seed)),
+        };
+        Ok((0..num_samples).map(|idx| {
+            let offset = match rng.as_mut() {
+                Some(rng) => (rng.next_u64() % (slack as u64 + 1)) as usize,
+                None => slack / 2,
+            };
+            let start = idx * part_len + offset;
+            Self {
+                warmup: start..start + warmup,
+                measure: start + warmup..start + unit,
+            }
+        }).collect())
+    }
+}
+
+/// Approximate evaluation of a single predictor on a subset of a trace.
+///
+/// Only a set of windows in the trace are simulated (see [Sample::place]).
+/// Each window begins with a functional warming prefix, where the
+/// predictor and history are updated without collecting statistics.
+/// Predictor state is carried over from one window to the next.
+///
+/// Misses and branches are counted separately in each window, so the
+/// variance between windows can be used to compute a confidence interval
+/// for the estimate (see [SampleResult]).
+pub struct SampledEvaluator {
+    pub spec: PredictorSpec,
+
+    /// Number of windows
+    pub num_samples: usize,
+
+    /// Number of warmup records for each window
+    pub warmup: usize,
+
+    /// Number of measured records in each window
+    pub measure: usize,
+
+    pub strategy: SampleStrategy,
+}
+impl SampledEvaluator {
+    pub fn new(spec: PredictorSpec, num_samples: usize, warmup: usize,
+        measure: usize, strategy: SampleStrategy) -> Self
+    {
+        Self { spec, num_samples, warmup, measure, strategy }
+    }
+
+    /// Evaluate the windows in some trace. 
+    /// Returns an error if the windows don't fit (see [Sample::place]).
+    pub fn run(&self, records: &[BranchRecord]) 
+        -> Result<SampleResult, String>
+    {
+        let samples = Sample::place(records.len(), self.num_samples,
+            self.warmup, self.measure, self.strategy)?;
+        let mut eval = MultiEvaluator::from_specs(&[self.spec.clone()]);
+        let mut res = SampleResult {
+            brns: Vec::with_capacity(samples.len()),
+            miss: Vec::with_capacity(samples.len()),
+            num_simulated: 0,
+        };
+        for sample in samples {
+            eval.warm_up(&records[sample.warmup.clone()]);
+            let stats = &eval.slots[0].stats;
+            let (brns, miss) = (stats.global_brns(), stats.global_miss());
+            eval.run(&records[sample.measure.clone()]);
+            let stats = &eval.slots[0].stats;
+            res.brns.push(stats.global_brns() - brns);
+            res.miss.push(stats.global_miss() - miss);
+            res.num_simulated += sample.warmup.len() + sample.measure.len();
+        }
+        Ok(res)
+    }
+}
+
+/// Results from a [SampledEvaluator].
+#[derive(Clone, Debug)]
+pub struct SampleResult {
+    /// Number of conditional branches measured in each window
+    pub brns: Vec<usize>,
+
+    /// Number of mispredictions measured in each window
+    pub miss: Vec<usize>,
+
+    /// Total number of records simulated [including warmup]
+    pub num_simulated: usize,
+}
+impl SampleResult {
+    pub fn num_samples(&self) -> usize { self.brns.len() }
+
+    /// Return the estimated MPKB.
+    ///
+    /// Windows have a fixed number of records, but not a fixed number of
+    /// conditional branches, so this is the ratio of the total misses to
+    /// the total branches over all windows [rather than the mean of the
+    /// MPKB in each window, which is biased].
+    pub fn mpkb(&self) -> f64 {
+        let brns: usize = self.brns.iter().sum();
+        let miss: usize = self.miss.iter().sum();
+        if brns == 0 {
+            return 0.0;
+        }
+        miss as f64 * 1000.0 / brns as f64
+    }
+
+    /// Return the standard deviation of the MPKB between windows, using 
+    /// the variance of the residuals 'miss - R * brns' for the ratio 
+    /// estimator R [scaled by the mean number of branches per window].
+    pub fn mpkb_stddev(&self) -> f64 {
+        let n = self.num_samples();
+        let brns: usize = self.brns.iter().sum();
+        if n < 2 || brns == 0 {
+            return 0.0;
+        }
+        let ratio = self.mpkb() / 1000.0;
+        let var = self.miss.iter().zip(self.brns.iter())
+            .map(|(m, b)| (*m as f64 - ratio * *b as f64).powi(2))
+            .sum::<f64>() / (n - 1) as f64;
+        let mean_brns = brns as f64 / n as f64;
+        var.sqrt() * 1000.0 / mean_brns
+    }
+
+    /// Return the half-width of a confidence interval for the MPKB with
+    /// some confidence level (ie. 0.95), using Student's t-distribution.
+    pub fn mpkb_interval(&self, level: f64) -> f64 {
+        let n = self.num_samples();
+        if n < 2 {
+            return f64::INFINITY;
+        }
+        let t = student_t_quantile(0.5 + level / 2.0, (n - 1) as f64);
+        t * self.mpkb_stddev() / (n as f64).sqrt()
+    }
+
+    /// Estimate the number of windows needed for a confidence interval
+    /// whose half-width is 'rel_error' times the MPKB [assuming that the
+    /// variance between windows stays the same].
+    pub fn required_samples(&self, rel_error: f64, level: f64) -> usize {
+        let mpkb = self.mpkb();
+        if mpkb == 0.0 {
+            return 2;
+        }
+        let z = normal_quantile(0.5 + level / 2.0);
+        let cv = self.mpkb_stddev() / mpkb;
+        ((z * cv / rel_error).powi(2).ceil() as usize).max(2)
+    }
+}
+
+/// Inverse of the standard normal CDF.
+///
+/// This is the rational approximation from "An algorithm for computing the
+/// inverse normal cumulative distribution function" (Acklam, 2003), with
+/// a relative error of about 1e-9.
+fn normal_quantile(p: f64) -> f64 {
+    assert!(p > 0.0 && p < 1.0);
+    const A: [f64; 6] = [-3.969683028665376e+01, 2.209460984245205e+02,
+        -2.759285104469687e+02, 1.383577518672690e+02,
+        -3.066479806614716e+01, 2.506628277459239e+00];
+    const B: [f64; 5] = [-5.447609879822406e+01, 1.615858368580409e+02,
+        -1.556989798598866e+02, 6.680131188771972e+01,
+        -1.328068155288572e+01];
+    const C: [f64; 6] = [-7.784894002430293e-03, -3.223964580411365e-01,
+        -2.400758277161838e+00, -2.549732539343734e+00,
+        4.374664141464968e+00, 2.938163982698783e+00];
+    const D: [f64; 4] = [7.784695709041462e-03, 3.224671290700398e-01,
+        2.445134137142996e+00, 3.754408661907416e+00];
+
+    let tail = |q: f64| {
+        (((((C[0]*q + C[1])*q + C[2])*q + C[3])*q + C[4])*q + C[5]) /
+        ((((D[0]*q + D[1])*q + D[2])*q + D[3])*q + 1.0)
+    };
+    if p < 0.02425 {
+        tail((-2.0 * p.ln()).sqrt())
+    } else if p > 1.0 - 0.02425 {
+        -tail((-2.0 * (1.0 - p).ln()).sqrt())
+    } else {
+        let q = p - 0.5;
+        let r = q * q;
+        (((((A[0]*r + A[1])*r + A[2])*r + A[3])*r + A[4])*r + A[5]) * q /
+        (((((B[0]*r + B[1])*r + B[2])*r + B[3])*r + B[4])*r + 1.0)
+    }
+}
+
+/// Inverse of the CDF of Student's t-distribution with 'dof' degrees of
+/// freedom.
+///
+/// This uses the Cornish-Fisher expansion around the normal quantile (see
+/// Abramowitz and Stegun, 26.7.5), which is accurate to a few parts in a
+/// thousand for 'dof' >= 3 at the usual confidence levels.
+fn student_t_quantile(p: f64, dof: f64) -> f64 {
+    let z = normal_quantile(p);
+    let z2 = z * z;
+    let g1 = (z2 + 1.0) * z / 4.0;
+    let g2 = ((5.0 * z2 + 16.0) * z2 + 3.0) * z / 96.0;
+    let g3 = (((3.0 * z2 + 19.0) * z2 + 17.0) * z2 - 15.0) * z / 384.0;
+    let g4 = ((((79.0 * z2 + 776.0) * z2 + 1482.0) * z2 - 1920.0) * z2
+        - 945.0) * z / 92160.0;
+    z + g1 / dof + g2 / dof.powi(2) + g3 / dof.powi(3) + g4 / dof.powi(4)
+}
+
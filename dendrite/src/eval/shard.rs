@@ -0,0 +1,127 @@
+
+use std::ops::Range;
+use crate::branch::*;
+use crate::eval::*;
+use crate::pool::*;
+use crate::stats::*;
+
+/// A contiguous part of a trace evaluated by a [ShardedEvaluator].
+#[derive(Clone, Debug, PartialEq, Eq)]
+pub struct Shard {
+    /// Records used to warm up the predictor [taken from the end of the 
+    /// previous shard]
+    pub warmup: Range<usize>,
+
+    /// Records being measured
+    pub measure: Range<usize>,
+}
+impl Shard {
+    /// Split a trace with 'len' records into 'num_shards' shards of equal
+    /// size, each with up to 'warmup' records from the previous shard. 
+    pub fn split(len: usize, num_shards: usize, warmup: usize) -> Vec<Self> {
+        assert!(num_shards != 0);
+        (0..num_shards).map(|idx| {
+            let start = idx * len / num_shards;
+            let end = (idx + 1) * len / num_shards;
+            Self {
+                warmup: start.saturating_sub(warmup)..start,
+                measure: start..end,
+            }
+        }).collect()
+    }
+}
+
+/// Approximate parallel evaluation of a single predictor on a trace.
+///
+/// The trace is split into [Shard]s which are evaluated independently on
+/// a [WorkPool], each with a freshly built predictor. Before measuring its
+/// shard, each predictor is warmed up on the tail of the previous shard 
+/// with statistics disabled. The statistics from all shards are merged. 
+///
+/// NOTE: Predictor state at the start of each shard only approximates the 
+/// state in a sequential run, so results are not exact. 
+/// See [ShardedEvaluator::estimate_error].
+pub struct ShardedEvaluator {
+    pub spec: PredictorSpec,
+    pub pool: WorkPool,
+
+    /// Number of shards
+    pub num_shards: usize,
+
+    /// Number of warmup records for each shard
+    pub warmup: usize,
+
+    /// Collect per-branch statistics
+    pub per_branch: bool,
+}
+impl ShardedEvaluator {
+    pub fn new(spec: PredictorSpec, pool: WorkPool, num_shards: usize, 
+        warmup: usize) -> Self
+    {
+        Self { spec, pool, num_shards, warmup, per_branch: false }
+    }
+
+    /// Evaluate each shard, returning the statistics for each shard.
+    pub fn run_shards(&self, records: &[BranchRecord]) -> Vec<BranchStats> {
+        let shards = Shard::split(records.len(), self.num_shards, self.warmup);
+        self.pool.map(shards, |_, shard| {
+            let mut eval = MultiEvaluator::from_specs(&[self.spec.clone()]);
+            eval.per_branch = self.per_branch;
+            eval.warm_up(&records[shard.warmup]);
+            eval.run(&records[shard.measure]);
+            eval.slots.pop().unwrap().stats
+        })
+    }
+
+    /// Evaluate all shards and merge the results.
+    pub fn run(&self, records: &[BranchRecord]) -> BranchStats {
+        let shards = self.run_shards(records);
+        BranchStats::merge_all(shards.iter()).unwrap_or(BranchStats::new())
+    }
+
+    /// Estimate the error introduced by sharding by comparing a sequential
+    /// run with a sharded run on the first 'sample_len' records.
+    ///
+    /// The sample is split into the same number of shards, so each shard 
+    /// is shorter than in the full run; the error is likely to be an 
+    /// overestimate. 
+    pub fn estimate_error(&self, records: &[BranchRecord], sample_len: usize)
+        -> ShardError
+    {
+        let sample = &records[..sample_len.min(records.len())];
+        let seq_pool = WorkPool::new(1);
+        let sequential = ShardedEvaluator::new(self.spec.clone(), seq_pool, 
+            1, 0).run(sample);
+        let sharded = self.run(sample);
+        ShardError { 
+            sample_len: sample.len(), 
+            sequential, 
+            sharded,
+        }
+    }
+}
+
+/// Comparison between a sequential and a sharded run on the same records.
+pub struct ShardError {
+    /// Number of records in the sample
+    pub sample_len: usize,
+
+    pub sequential: BranchStats,
+    pub sharded: BranchStats,
+}
+impl ShardError {
+    /// Difference in hit rate (sharded - sequential).
+    pub fn hit_rate_error(&self) -> f64 {
+        self.sharded.hit_rate() - self.sequential.hit_rate()
+    }
+
+    /// Difference in misses per thousand branches (sharded - sequential).
+    pub fn mpkb_error(&self) -> f64 {
+        Self::mpkb(&self.sharded) - Self::mpkb(&self.sequential)
+    }
+
+    fn mpkb(stats: &BranchStats) -> f64 {
+        stats.global_miss() as f64 * 1000.0 / stats.global_brns() as f64
+    }
+}
+
@@ -0,0 +1,108 @@
+
+use crate::branch::*;
+use crate::eval::*;
+use crate::stats::*;
+
+/// Evaluates predictors on the representative intervals in a 
+/// [SimPointList].
+///
+/// Intervals are evaluated in order, each preceded by up to 'warmup' 
+/// records where the predictors are updated without collecting statistics.
+/// Predictor state is carried over from one interval to the next.
+pub struct SimPointEvaluator {
+    pub specs: Vec<PredictorSpec>,
+
+    /// Number of warmup records before each interval
+    pub warmup: usize,
+}
+impl SimPointEvaluator {
+    pub fn new(specs: &[PredictorSpec], warmup: usize) -> Self {
+        Self { specs: specs.to_vec(), warmup }
+    }
+
+    pub fn run(&self, records: &[BranchRecord], list: &SimPointList)
+        -> SimPointResult
+    {
+        let mut eval = MultiEvaluator::from_specs(&self.specs);
+        let mut res = SimPointResult {
+            names: eval.slots.iter().map(|s| s.name.clone()).collect(),
+            weights: Vec::new(),
+            lens: Vec::new(),
+            brns: vec![Vec::new(); self.specs.len()],
+            miss: vec![Vec::new(); self.specs.len()],
+            num_simulated: 0,
+            num_measured: 0,
+        };
+        let mut prev_end = 0;
+        for point in list.points.iter() {
+            let start = point.interval * list.interval_len;
+            let end = (start + list.interval_len).min(records.len());
+            assert!(start < end, "interval {} is outside of the trace", 
+                point.interval);
+
+            // Don't warm up on records that were already simulated
+            let warmup_start = start.saturating_sub(self.warmup).max(prev_end);
+            eval.warm_up(&records[warmup_start..start]);
+            let before: Vec<(usize, usize)> = eval.slots.iter()
+                .map(|s| (s.stats.global_brns(), s.stats.global_miss()))
+                .collect();
+            eval.run(&records[start..end]);
+            for (idx, slot) in eval.slots.iter().enumerate() {
+                res.brns[idx].push(slot.stats.global_brns() - before[idx].0);
+                res.miss[idx].push(slot.stats.global_miss() - before[idx].1);
+            }
+            res.weights.push(point.weight);
+            res.lens.push(end - start);
+            res.num_simulated += end - warmup_start;
+            res.num_measured += end - start;
+            prev_end = end;
+        }
+        res
+    }
+}
+
+/// Results from a [SimPointEvaluator].
+#[derive(Clone, Debug)]
+pub struct SimPointResult {
+    /// Name of each predictor
+    pub names: Vec<String>,
+
+    /// Weight of each interval
+    pub weights: Vec<f64>,
+
+    /// Number of records in each interval
+    pub lens: Vec<usize>,
+
+    /// Conditional branches measured in each interval [for each predictor]
+    pub brns: Vec<Vec<usize>>,
+
+    /// Mispredictions measured in each interval [for each predictor]
+    pub miss: Vec<Vec<usize>>,
+
+    /// Total number of records simulated [including warmup]
+    pub num_simulated: usize,
+
+    /// Total number of records measured
+    pub num_measured: usize,
+}
+impl SimPointResult {
+    /// Return the MPKB for some predictor.
+    ///
+    /// Each interval stands for the fraction of records given by its
+    /// weight, so the misses and branches per record in each interval are
+    /// scaled by the weight and summed, and the MPKB is the ratio of the
+    /// sums [rather than a weighted mean of the MPKB in each interval].
+    pub fn weighted_mpkb(&self, idx: usize) -> f64 {
+        let mut brns = 0.0;
+        let mut miss = 0.0;
+        for (i, w) in self.weights.iter().enumerate() {
+            let scale = w / self.lens[i] as f64;
+            brns += self.brns[idx][i] as f64 * scale;
+            miss += self.miss[idx][i] as f64 * scale;
+        }
+        if brns == 0.0 {
+            return 0.0;
+        }
+        miss * 1000.0 / brns
+    }
+}
@@ -0,0 +1,91 @@
+
+use crate::branch::*;
+use crate::eval::*;
+use crate::checkpoint::*;
+use crate::codec::*;
+use crate::heap::*;
+use crate::stats::*;
+
+/// Evaluates a single [ConditionalPredictor] on a trace.
+///
+/// Unlike [MultiEvaluator], the type of the predictor is known at compile 
+/// time, so the evaluation loop is specialized for each predictor.
+pub struct Evaluator<P: ConditionalPredictor> {
+    pub hist: EvalHistory,
+    pub predictor: P,
+    pub stats: BranchStats,
+
+    /// Collect per-branch statistics
+    pub per_branch: bool,
+}
+impl <P: ConditionalPredictor> Evaluator<P> {
+    pub fn new(predictor: P) -> Self {
+        Self {
+            hist: EvalHistory::new(),
+            predictor,
+            stats: BranchStats::new(),
+            per_branch: false,
+        }
+    }
+
+    /// Evaluate a single record.
+    #[inline(always)]
+    pub fn step(&mut self, record: &BranchRecord) {
+        self.step_with(record, |_, _, _| {});
+    }
+
+    /// Evaluate a single record. 
+    /// 
+    /// For conditional branches, 'f' is called with the predictor and the
+    /// prediction after the predictor has been updated. 
+    #[inline(always)]
+    pub fn step_with(&mut self, record: &BranchRecord,
+        f: impl FnOnce(&P, &BranchRecord, &BranchPrediction<P::Meta>))
+    {
+        if record.is_conditional() {
+            let p = self.predictor.predict_branch(record, &self.hist);
+            self.predictor.update_branch(record, &self.hist, &p);
+            self.stats.update_global(record, p.outcome);
+            self.stats.update_confidence(record, p.outcome, p.confidence);
+            if self.per_branch {
+                self.stats.update_per_branch(record, p.outcome);
+            }
+            f(&self.predictor, record, &p);
+        }
+        self.hist.update(record);
+        ConditionalPredictor::update_history(&mut self.predictor, &self.hist);
+    }
+
+    /// Evaluate a list of records.
+    pub fn run(&mut self, records: &[BranchRecord]) {
+        for record in records {
+            self.step(record);
+        }
+    }
+}
+impl <P: ConditionalPredictor + HeapSize> Evaluator<P> {
+    /// Return a breakdown of the memory used by the predictor, history
+    /// registers, and statistics.
+    pub fn heap_usage(&self, name: &str) -> HeapUsage {
+        HeapUsage::from_children(name, vec![
+            HeapSize::heap_usage(&self.predictor, "predictor"),
+            self.hist.heap_usage("history"),
+            self.stats.heap_usage("stats"),
+        ])
+    }
+}
+
+impl <P: ConditionalPredictor + SaveState> SaveState for Evaluator<P> {
+    fn save_state(&self, e: &mut Encoder) {
+        self.hist.save_state(e);
+        SaveState::save_state(&self.predictor, e);
+        self.stats.encode(e);
+    }
+
+    fn restore_state(&mut self, d: &mut Decoder) -> Option<()> {
+        self.hist.restore_state(d)?;
+        SaveState::restore_state(&mut self.predictor, d)?;
+        self.stats = BranchStats::decode(d)?;
+        Some(())
+    }
+}
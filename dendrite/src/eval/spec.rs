@@ -0,0 +1,169 @@
+
+use crate::branch::*;
+use crate::eval::*;
+use crate::predictor::*;
+use crate::predictor::gshare::*;
+use crate::predictor::pht::*;
+use crate::predictor::simple::*;
+
+/// A description of some predictor configuration, parsed from a string.
+///
+/// - `taken`, `not-taken`, `random`: trivial predictors
+/// - `pht:<n>`: a table of 2^n counters indexed by the program counter
+/// - `gshare:<n>`: a table of 2^n counters indexed by the program counter
+///   and 'n' bits of global history
+/// - `perceptron:<n>[:<h>]`: a table of 2^n perceptrons using 'h' bits of
+///   global history (either 16, 32, or 64; the default is 32)
+/// - `tage[:<seed>]`: the default [TAGEPredictor] configuration, 
+///   optionally with deterministic allocation (see [TAGEConfig::alloc_seed])
+/// - `<filter>+<predictor>`: a [BranchFilter] in front of some predictor
+///   (see [FilterSpec] and [FilteredPredictor])
+///
+/// Table sizes must be at least 1 and at most [PredictorSpec::MAX_TABLE_BITS]
+/// (or [PredictorSpec::MAX_PERCEPTRON_BITS] for perceptrons).
+#[derive(Clone, Debug, PartialEq, Eq, Hash)]
+pub enum PredictorSpec {
+    Taken,
+    NotTaken,
+    Random,
+    Pht(usize),
+    Gshare(usize),
+    Perceptron(usize, usize),
+    Tage(Option<u64>),
+    Filtered(FilterSpec, Box<PredictorSpec>),
+}
+impl PredictorSpec {
+    /// Largest number of index bits for a table of counters
+    pub const MAX_TABLE_BITS: usize = 28;
+
+    /// Largest number of index bits for a table of perceptrons
+    pub const MAX_PERCEPTRON_BITS: usize = 24;
+
+    pub fn parse(s: &str) -> Result<Self, String> {
+        if let Some((filter, inner)) = s.split_once('+') {
+            let filter = FilterSpec::parse(filter)?;
+            return Ok(Self::Filtered(filter, Box::new(Self::parse(inner)?)));
+        }
+        let mut fields = s.split(':');
+        let kind = fields.next().unwrap();
+        let args: Vec<usize> = fields.map(|f| f.parse::<usize>())
+            .collect::<Result<_, _>>()
+            .map_err(|e| format!("invalid predictor '{}': {}", s, e))?;
+
+        let table = 1..=Self::MAX_TABLE_BITS;
+        let perceptron = 1..=Self::MAX_PERCEPTRON_BITS;
+        let res = match (kind, args.as_slice()) {
+            ("taken", []) => Self::Taken,
+            ("not-taken", []) => Self::NotTaken,
+            ("random", []) => Self::Random,
+            ("pht", [n]) if table.contains(n) => Self::Pht(*n),
+            ("gshare", [n]) if table.contains(n) => Self::Gshare(*n),
+            ("perceptron", [n]) if perceptron.contains(n) => {
+                Self::Perceptron(*n, 32)
+            },
+            ("perceptron", [n, h]) 
+                if perceptron.contains(n) && matches!(h, 16 | 32 | 64) => 
+            {
+                Self::Perceptron(*n, *h)
+            },
+            ("tage", []) => Self::Tage(None),
+            ("tage", [seed]) => Self::Tage(Some(*seed as u64)),
+            _ => return Err(format!("invalid predictor '{}'", s)),
+        };
+        Ok(res)
+    }
+
+    /// Parse a list of predictor specifications.
+    pub fn parse_list(list: &[String]) -> Result<Vec<Self>, String> {
+        list.iter().map(|s| Self::parse(s)).collect()
+    }
+
+    /// Create a new predictor with this configuration.
+    pub fn build(&self) -> Box<dyn EvalPredictor + Send> {
+        self.build_partition(1).unwrap()
+    }
+
+    /// Create a new predictor with 1/'num_parts' of the table entries in 
+    /// this configuration [where 'num_parts' is a power of two]. 
+    ///
+    /// Only the number of entries changes: history lengths are the same as
+    /// in the original configuration. Returns an error if any table would 
+    /// be left with fewer than two entries.
+    pub fn build_partition(&self, num_parts: usize) 
+        -> Result<Box<dyn EvalPredictor + Send>, String>
+    {
+        assert!(num_parts.is_power_of_two());
+        let shift = num_parts.ilog2() as usize;
+        let check = |bits: usize| {
+            if shift < bits {
+                Ok(bits - shift)
+            } else {
+                Err(format!("{} cannot be divided into {} parts", 
+                    self, num_parts))
+            }
+        };
+        let ctr = SaturatingCounterConfig {
+            max_t_state: 1,
+            max_n_state: 1,
+            default_state: Outcome::N,
+        };
+        let res: Box<dyn EvalPredictor + Send> = match self {
+            Self::Taken => Box::new(TakenPredictor),
+            Self::NotTaken => Box::new(NotTakenPredictor),
+            Self::Random => Box::new(RandomPredictor),
+            Self::Pht(n) => {
+                Box::new(SimplePHT::new(1 << check(*n)?, index_direct, ctr))
+            },
+            Self::Gshare(n) => {
+                Box::new(GsharePredictor::new(1 << check(*n)?, *n, ctr))
+            },
+            Self::Perceptron(n, 16) => {
+                Box::new(PerceptronTable::<16>::new(1 << check(*n)?))
+            },
+            Self::Perceptron(n, 32) => {
+                Box::new(PerceptronTable::<32>::new(1 << check(*n)?))
+            },
+            Self::Perceptron(n, 64) => {
+                Box::new(PerceptronTable::<64>::new(1 << check(*n)?))
+            },
+            Self::Perceptron(_, h) => unreachable!("unsupported history length {}", h),
+            Self::Tage(seed) => {
+                let mut cfg = TAGEConfig::preset_default();
+                cfg.alloc_seed = *seed;
+                cfg.base.size = 1 << check(cfg.base.size.ilog2() as usize)?;
+                for c in cfg.comp.iter_mut() {
+                    c.size = 1 << check(c.size.ilog2() as usize)?;
+                }
+                Box::new(cfg.build())
+            },
+            Self::Filtered(filter, inner) => {
+                Box::new(FilteredPredictor::new(
+                    filter.build_partition(num_parts)?,
+                    inner.build_partition(num_parts)?,
+                ))
+            },
+        };
+        Ok(res)
+    }
+}
+impl std::fmt::Display for PredictorSpec {
+    fn fmt(&self, f: &mut std::fmt::Formatter) -> std::fmt::Result {
+        match self {
+            Self::Taken => write!(f, "taken"),
+            Self::NotTaken => write!(f, "not-taken"),
+            Self::Random => write!(f, "random"),
+            Self::Pht(n) => write!(f, "pht:{}", n),
+            Self::Gshare(n) => write!(f, "gshare:{}", n),
+            Self::Perceptron(n, h) => write!(f, "perceptron:{}:{}", n, h),
+            Self::Tage(None) => write!(f, "tage"),
+            Self::Tage(Some(seed)) => write!(f, "tage:{}", seed),
+            Self::Filtered(filter, inner) => write!(f, "{}+{}", filter, inner),
+        }
+    }
+}
+
+/// Index function for a [SimplePHT] (using the program counter directly).
+fn index_direct(pht: &SimplePHT, pc: usize) -> usize {
+    pc
+}
+
@@ -0,0 +1,128 @@
+//! Helpers for measuring the host memory used by predictors and statistics.
+//!
+//! Unlike the modeled hardware storage (ie. [crate::TAGEConfig::storage_bits]),
+//! this counts the bytes actually allocated on the heap by the simulator,
+//! including debugging/analysis state.
+
+use std::collections::*;
+use std::mem::size_of;
+use bitvec::prelude::*;
+
+/// Types that can report the number of bytes they own on the heap.
+pub trait HeapSize {
+    /// Number of bytes owned on the heap [not including 'self'].
+    fn heap_bytes(&self) -> usize;
+
+    /// Return a breakdown of heap usage. 
+    /// By default, this is a single entry without any children.
+    fn heap_usage(&self, name: &str) -> HeapUsage {
+        HeapUsage::new(name, self.heap_bytes())
+    }
+}
+
+/// A named amount of heap memory, optionally broken down into parts.
+#[derive(Clone, Debug)]
+pub struct HeapUsage {
+    pub name: String,
+
+    /// Total number of bytes
+    pub bytes: usize,
+
+    /// Breakdown of the total
+    pub children: Vec<HeapUsage>,
+}
+impl HeapUsage {
+    pub fn new(name: impl ToString, bytes: usize) -> Self {
+        Self { name: name.to_string(), bytes, children: Vec::new() }
+    }
+
+    /// Create an entry whose total is the sum of its children.
+    pub fn from_children(name: impl ToString, children: Vec<HeapUsage>) 
+        -> Self
+    {
+        let bytes = children.iter().map(|c| c.bytes).sum();
+        Self { name: name.to_string(), bytes, children }
+    }
+
+    fn fmt_indent(&self, f: &mut std::fmt::Formatter, depth: usize) 
+        -> std::fmt::Result
+    {
+        writeln!(f, "{:indent$}{:<32} {:12} bytes ({:.2}KiB)", "", 
+            self.name, self.bytes, self.bytes as f64 / 1024.0,
+            indent = depth * 2)?;
+        for child in self.children.iter() {
+            child.fmt_indent(f, depth + 1)?;
+        }
+        Ok(())
+    }
+}
+impl std::fmt::Display for HeapUsage {
+    fn fmt(&self, f: &mut std::fmt::Formatter) -> std::fmt::Result {
+        self.fmt_indent(f, 0)
+    }
+}
+
+macro_rules! impl_heap_size_zero {
+    ($($t:ty),*) => {
+        $(impl HeapSize for $t { fn heap_bytes(&self) -> usize { 0 } })*
+    }
+}
+impl_heap_size_zero!(u8, u16, u32, u64, usize, i8, i16, i32, i64, f64, bool);
+
+impl HeapSize for String {
+    fn heap_bytes(&self) -> usize { self.capacity() }
+}
+
+impl <T: HeapSize> HeapSize for Vec<T> {
+    fn heap_bytes(&self) -> usize {
+        self.capacity() * size_of::<T>() 
+            + self.iter().map(|x| x.heap_bytes()).sum::<usize>()
+    }
+}
+
+impl <T: HeapSize> HeapSize for Option<T> {
+    fn heap_bytes(&self) -> usize {
+        self.as_ref().map(|x| x.heap_bytes()).unwrap_or(0)
+    }
+}
+
+impl HeapSize for BitVec {
+    fn heap_bytes(&self) -> usize {
+        let words = (self.capacity() + usize::BITS as usize - 1) 
+            / usize::BITS as usize;
+        words * size_of::<usize>()
+    }
+}
+
+/// Approximate cost of a single entry in a [BTreeMap] or [BTreeSet].
+///
+/// Nodes have room for 11 entries and are typically about 2/3 full, and 
+/// internal nodes are ignored.
+fn btree_entry_bytes<K, V>() -> usize {
+    (size_of::<K>() + size_of::<V>()) * 3 / 2
+}
+
+impl <K: HeapSize, V: HeapSize> HeapSize for BTreeMap<K, V> {
+    fn heap_bytes(&self) -> usize {
+        self.len() * btree_entry_bytes::<K, V>()
+            + self.iter().map(|(k, v)| k.heap_bytes() + v.heap_bytes())
+                .sum::<usize>()
+    }
+}
+
+impl <K: HeapSize> HeapSize for BTreeSet<K> {
+    fn heap_bytes(&self) -> usize {
+        self.len() * btree_entry_bytes::<K, ()>()
+            + self.iter().map(|k| k.heap_bytes()).sum::<usize>()
+    }
+}
+
+/// Includes one control byte for each bucket.
+impl <K: HeapSize, V: HeapSize, S> HeapSize for HashMap<K, V, S> {
+    fn heap_bytes(&self) -> usize {
+        self.capacity() * (size_of::<(K, V)>() + 1)
+            + self.iter().map(|(k, v)| k.heap_bytes() + v.heap_bytes())
+                .sum::<usize>()
+    }
+}
+
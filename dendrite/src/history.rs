@@ -1,8 +1,12 @@
 
 use bitvec::prelude::*;
+use crate::heap::HeapSize;
+use crate::checkpoint::SaveState;
+use crate::codec::*;
 use std::ops::{ RangeInclusive };
 
 
+#[derive(Clone, Debug)]
 pub struct HistoryRegister {
     pub data: BitVec<usize, Lsb0>,
     len: usize,
@@ -35,8 +39,27 @@ impl HistoryRegister {
     pub fn len(&self) -> usize { self.len }
     pub fn data(&self) -> &BitVec { &self.data }
     pub fn data_mut(&mut self) -> &mut BitVec { &mut self.data }
+
+    /// Clear all bits in the register.
+    pub fn reset(&mut self) { self.data.fill(false) }
+}
+
+
+impl HeapSize for HistoryRegister {
+    fn heap_bytes(&self) -> usize { self.data.heap_bytes() }
 }
 
+impl SaveState for HistoryRegister {
+    fn save_state(&self, e: &mut Encoder) { e.put_bits(&self.data) }
+    fn restore_state(&mut self, d: &mut Decoder) -> Option<()> {
+        let bits = d.get_bits()?;
+        if bits.len() != self.data.len() {
+            return None;
+        }
+        self.data = bits;
+        Some(())
+    }
+}
 
 impl HistoryRegister {
     /// Shift the register by 'n' bits. 
@@ -102,12 +125,22 @@ impl FoldedHistoryRegister {
         }
     }
 
+    /// Clear the folded history.
+    pub fn reset(&mut self) { self.data.fill(false) }
+
     /// Return the folded history as a [BitSlice].
     pub fn output(&self) -> &BitSlice { self.data.as_bitslice() }
 
     /// Return the folded history as a [usize].
     pub fn output_usize(&self) -> usize { self.data.load::<usize>() }
 
+    /// Recompute the folded history from scratch with [HistoryRegister::fold].
+    /// This is the reference behavior for [FoldedHistoryRegister::update].
+    pub fn update_reference(&mut self, ghr: &HistoryRegister) {
+        let val = ghr.fold(self.ghist_range.clone(), self.output_size);
+        self.data.store(val);
+    }
+
     /// Using some [HistoryRegister], update the folded history.
     pub fn update(&mut self, ghr: &HistoryRegister) {
 
@@ -132,4 +165,48 @@ impl FoldedHistoryRegister {
     }
 }
 
+impl HeapSize for FoldedHistoryRegister {
+    fn heap_bytes(&self) -> usize { self.data.heap_bytes() }
+}
+
+impl SaveState for FoldedHistoryRegister {
+    fn save_state(&self, e: &mut Encoder) { e.put_bits(&self.data) }
+    fn restore_state(&mut self, d: &mut Decoder) -> Option<()> {
+        let bits = d.get_bits()?;
+        if bits.len() != self.output_size {
+            return None;
+        }
+        self.data = bits;
+        Some(())
+    }
+}
+
+/// Fold a program counter value into 12 bits. 
+///
+/// NOTE: I get the impression that this is unreasonably effective, but then
+/// again, we're folding 36 bits of the program counter, and this is probably
+/// expensive in hardware? 
+pub fn fold_pc_12b(pc: usize) -> usize { 
+    let lo  = pc & 0b0000_0000_0000_0000_0000_0000_1111_1111_1111;
+    let hi  = pc & 0b0000_0000_0000_1111_1111_1111_0000_0000_0000 >> 12;
+    let hi2 = pc & 0b1111_1111_1111_0000_0000_0000_0000_0000_0000 >> 24;
+    lo ^ hi ^ hi2
+}
+
+/// Update the path history register. 
+/// - Fold program counter into 12 bits
+/// - Shift the PHR by one
+/// - XOR the folded program counter with the low 12 bits in the PHR
+pub fn update_phr(pc: usize, phr: &mut HistoryRegister) {
+    update_phr_folded(fold_pc_12b(pc), phr);
+}
+
+/// Update the path history register with a program counter that has 
+/// already been folded with [fold_pc_12b].
+pub fn update_phr_folded(pc_bits: usize, phr: &mut HistoryRegister) {
+    phr.shift_by(1);
+    let phr_bits = phr.data()[0..=11].load::<usize>();
+    let new_bits = pc_bits ^ phr_bits;
+    phr.data_mut()[0..=11].store(new_bits);
+}
 
@@ -0,0 +1,180 @@
+//! Backing large tables and trace buffers with huge pages.
+//!
+//! Large predictor tables and whole traces are accessed with random or
+//! streaming patterns that miss in the TLB with 4KiB pages. When enabled
+//! with [set_huge_pages], large allocations made with [huge_vec] are
+//! advised with `madvise(MADV_HUGEPAGE)` before they are touched, so that
+//! the kernel can back them with transparent huge pages.
+//!
+//! Whether the kernel actually used huge pages is only visible afterwards
+//! (see [HugePageReport]). On targets other than Linux, this does nothing.
+
+use std::sync::atomic::{ AtomicBool, AtomicUsize, Ordering };
+
+/// The size of a huge page on x86_64 and aarch64 [with 4KiB base pages].
+pub const HUGE_PAGE_SIZE: usize = 2 << 20;
+
+static ENABLED: AtomicBool = AtomicBool::new(false);
+static ADVISED_BYTES: AtomicUsize = AtomicUsize::new(0);
+static ADVISED_REGIONS: AtomicUsize = AtomicUsize::new(0);
+static FAILED_REGIONS: AtomicUsize = AtomicUsize::new(0);
+
+#[cfg(target_os = "linux")]
+mod sys {
+    pub const MADV_HUGEPAGE: i32 = 14;
+    extern "C" {
+        pub fn madvise(addr: *mut u8, len: usize, advice: i32) -> i32;
+    }
+}
+
+/// Enable or disable huge pages for allocations made with [huge_vec].
+/// This is disabled by default.
+pub fn set_huge_pages(enabled: bool) {
+    ENABLED.store(enabled, Ordering::Relaxed);
+}
+
+pub fn huge_pages_enabled() -> bool {
+    ENABLED.load(Ordering::Relaxed)
+}
+
+/// Advise the kernel to use huge pages for the aligned part of some region.
+/// Returns the number of bytes advised, or [None] if the request failed.
+#[cfg(target_os = "linux")]
+fn advise(ptr: *mut u8, len: usize) -> Option<usize> {
+    let start = (ptr as usize + HUGE_PAGE_SIZE - 1) & !(HUGE_PAGE_SIZE - 1);
+    let end = (ptr as usize + len) & !(HUGE_PAGE_SIZE - 1);
+    if end <= start {
+        return Some(0);
+    }
+    let res = unsafe {
+        sys::madvise(start as *mut u8, end - start, sys::MADV_HUGEPAGE)
+    };
+    if res == 0 { Some(end - start) } else { None }
+}
+
+#[cfg(not(target_os = "linux"))]
+fn advise(_ptr: *mut u8, _len: usize) -> Option<usize> { None }
+
+/// Return an empty vector with room for 'len' elements which has been
+/// advised to use huge pages, or [None] if huge pages are disabled or the
+/// vector would be smaller than [HUGE_PAGE_SIZE].
+///
+/// The capacity is padded by one huge page so that all of the elements
+/// can be covered by aligned huge pages. The memory is advised before any
+/// elements are written.
+fn advised_vec<T>(len: usize) -> Option<Vec<T>> {
+    let elem_size = std::mem::size_of::<T>().max(1);
+    if !huge_pages_enabled() || len * elem_size < HUGE_PAGE_SIZE {
+        return None;
+    }
+
+    let pad = (HUGE_PAGE_SIZE + elem_size - 1) / elem_size;
+    let mut res: Vec<T> = Vec::with_capacity(len + pad);
+    let cap_bytes = res.capacity() * elem_size;
+    match advise(res.as_mut_ptr() as *mut u8, cap_bytes) {
+        Some(n) => {
+            ADVISED_BYTES.fetch_add(n, Ordering::Relaxed);
+            ADVISED_REGIONS.fetch_add(1, Ordering::Relaxed);
+        },
+        None => {
+            FAILED_REGIONS.fetch_add(1, Ordering::Relaxed);
+        },
+    }
+    Some(res)
+}
+
+/// Create a vector of 'len' elements, where each element is created by
+/// calling 'f' with its index. See [advised_vec].
+pub fn huge_vec_with<T>(len: usize, f: impl FnMut(usize) -> T) -> Vec<T> {
+    match advised_vec(len) {
+        Some(mut res) => {
+            res.extend((0..len).map(f));
+            res
+        },
+        None => (0..len).map(f).collect(),
+    }
+}
+
+/// Create a vector with 'len' copies of some value (like [vec!]).
+/// See [advised_vec].
+///
+/// When huge pages are disabled, this is exactly `vec![val; len]` [which
+/// can use a zeroed allocation for zero values, ie. for large buffers that
+/// are about to be overwritten].
+pub fn huge_vec<T: Clone>(len: usize, val: T) -> Vec<T> {
+    match advised_vec(len) {
+        Some(mut res) => {
+            res.resize(len, val);
+            res
+        },
+        None => vec![val; len],
+    }
+}
+
+/// Summary of the huge pages requested with [huge_vec] and the huge pages
+/// actually used by this process.
+#[derive(Clone, Copy, Debug)]
+pub struct HugePageReport {
+    /// Whether huge pages were enabled
+    pub enabled: bool,
+
+    /// Number of regions successfully advised
+    pub advised_regions: usize,
+
+    /// Number of bytes successfully advised
+    pub advised_bytes: usize,
+
+    /// Number of regions where advice was rejected by the kernel
+    pub failed_regions: usize,
+
+    /// Number of bytes backed by transparent huge pages in this process
+    /// (from 'AnonHugePages' in /proc/self/smaps_rollup), if available
+    pub backed_bytes: Option<usize>,
+
+    /// The system-wide transparent huge page policy
+    /// (from /sys/kernel/mm/transparent_hugepage/enabled), if available
+    pub policy: Option<&'static str>,
+}
+impl HugePageReport {
+    pub fn collect() -> Self {
+        Self {
+            enabled: huge_pages_enabled(),
+            advised_regions: ADVISED_REGIONS.load(Ordering::Relaxed),
+            advised_bytes: ADVISED_BYTES.load(Ordering::Relaxed),
+            failed_regions: FAILED_REGIONS.load(Ordering::Relaxed),
+            backed_bytes: anon_huge_page_bytes(),
+            policy: thp_policy(),
+        }
+    }
+}
+impl std::fmt::Display for HugePageReport {
+    fn fmt(&self, f: &mut std::fmt::Formatter) -> std::fmt::Result {
+        let kib = |x: usize| x as f64 / 1024.0;
+        write!(f, "enabled={} policy={} advised={} ({:.0}KiB) failed={} ",
+            self.enabled, self.policy.unwrap_or("unknown"),
+            self.advised_regions, kib(self.advised_bytes),
+            self.failed_regions)?;
+        match self.backed_bytes {
+            Some(b) => write!(f, "backed={:.0}KiB", kib(b)),
+            None => write!(f, "backed=unknown"),
+        }
+    }
+}
+
+/// Return the number of bytes backed by transparent huge pages in this
+/// process.
+fn anon_huge_page_bytes() -> Option<usize> {
+    let s = std::fs::read_to_string("/proc/self/smaps_rollup").ok()?;
+    let line = s.lines().find(|l| l.starts_with("AnonHugePages:"))?;
+    let kib: usize = line.split_whitespace().nth(1)?.parse().ok()?;
+    Some(kib * 1024)
+}
+
+/// Return the selected transparent huge page policy (the entry in brackets).
+fn thp_policy() -> Option<&'static str> {
+    let path = "/sys/kernel/mm/transparent_hugepage/enabled";
+    let s = std::fs::read_to_string(path).ok()?;
+    ["always", "madvise", "never"].into_iter()
+        .find(|p| s.contains(&format!("[{}]", p)))
+}
+
@@ -8,11 +8,27 @@ pub mod predictor;
 pub mod trace;
 pub mod stats;
 pub mod branch;
+pub mod codec;
+pub mod checkpoint;
+pub mod heap;
+pub mod hugepage;
+pub mod eval;
+pub mod pool;
+pub mod ring;
+pub mod args;
 
 pub use branch::*;
 pub use trace::*;
 pub use history::*;
 pub use predictor::*;
 pub use stats::*;
+pub use codec::*;
+pub use checkpoint::*;
+pub use heap::*;
+pub use hugepage::*;
+pub use eval::*;
+pub use pool::*;
+pub use ring::*;
+pub use args::*;
 
 
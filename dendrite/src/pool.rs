@@ -0,0 +1,93 @@
+//! A simple work-stealing thread pool.
+
+use std::collections::*;
+use std::sync::Mutex;
+
+/// A pool of worker threads used to run a list of independent jobs.
+///
+/// Jobs are initially split into contiguous blocks [one for each worker],
+/// so neighboring jobs tend to run on the same thread. Each worker takes
+/// jobs from the front of its own queue; when its queue is empty, it steals
+/// jobs from the back of another worker's queue.
+#[derive(Clone, Copy, Debug)]
+pub struct WorkPool {
+    num_threads: usize,
+}
+impl WorkPool {
+    pub fn new(num_threads: usize) -> Self {
+        assert!(num_threads != 0);
+        Self { num_threads }
+    }
+
+    /// Create a pool with one thread for each available CPU.
+    pub fn with_available_parallelism() -> Self {
+        let n = std::thread::available_parallelism()
+            .map(|n| n.get())
+            .unwrap_or(1);
+        Self::new(n)
+    }
+
+    pub fn num_threads(&self) -> usize { self.num_threads }
+
+    /// Run a function on each job, returning the results in the same order
+    /// as the list of jobs. The function is also passed the index of the
+    /// job in the list.
+    pub fn map<T, R, F>(&self, jobs: Vec<T>, f: F) -> Vec<R>
+        where T: Send, R: Send, F: Fn(usize, T) -> R + Sync
+    {
+        let num_jobs = jobs.len();
+        let num_workers = self.num_threads.min(num_jobs).max(1);
+
+        // Split the jobs into contiguous blocks
+        let mut queues: Vec<Mutex<VecDeque<(usize, T)>>> = (0..num_workers)
+            .map(|_| Mutex::new(VecDeque::new()))
+            .collect();
+        let block_size = ((num_jobs + num_workers - 1) / num_workers).max(1);
+        for (idx, job) in jobs.into_iter().enumerate() {
+            let q = idx / block_size;
+            queues[q].get_mut().unwrap().push_back((idx, job));
+        }
+
+        let results: Vec<Mutex<Option<R>>> = (0..num_jobs)
+            .map(|_| Mutex::new(None))
+            .collect();
+
+        std::thread::scope(|s| {
+            for id in 0..num_workers {
+                let queues = &queues;
+                let results = &results;
+                let f = &f;
+                // No new jobs are created while running, so a worker can
+                // exit as soon as every queue is empty.
+                s.spawn(move || {
+                    while let Some((idx, job)) = Self::next_job(queues, id) {
+                        let res = f(idx, job);
+                        *results[idx].lock().unwrap() = Some(res);
+                    }
+                });
+            }
+        });
+
+        results.into_iter()
+            .map(|r| r.into_inner().unwrap().unwrap())
+            .collect()
+    }
+
+    /// Take a job from the front of our own queue, or steal a job from the
+    /// back of some other queue.
+    fn next_job<T>(queues: &[Mutex<VecDeque<(usize, T)>>], id: usize)
+        -> Option<(usize, T)>
+    {
+        if let Some(job) = queues[id].lock().unwrap().pop_front() {
+            return Some(job);
+        }
+        for off in 1..queues.len() {
+            let victim = (id + off) % queues.len();
+            if let Some(job) = queues[victim].lock().unwrap().pop_back() {
+                return Some(job);
+            }
+        }
+        None
+    }
+}
+
@@ -42,6 +42,27 @@ pub enum TagStrategy<T> {
     FromPc(PcIndexFn<T>),
 }
 
+/// A measure of confidence in some prediction, from zero (no confidence) 
+/// to [Confidence::MAX].
+#[derive(Clone, Copy, Debug, PartialEq, Eq, PartialOrd, Ord, Hash)]
+pub struct Confidence(pub u8);
+impl Confidence {
+    pub const MAX: u8 = u8::MAX;
+
+    /// Create a confidence value from the ratio 'num / den'. 
+    /// When 'den' is zero, the prediction is assumed to be fully confident. 
+    pub fn from_ratio(num: usize, den: usize) -> Self {
+        if den == 0 {
+            return Self(Self::MAX);
+        }
+        let val = (num.min(den) * Self::MAX as usize) / den;
+        Self(val as u8)
+    }
+
+    /// Return the confidence as a value between 0.0 and 1.0.
+    pub fn as_f64(&self) -> f64 { self.0 as f64 / Self::MAX as f64 }
+}
+
 /// Interface to a "trivial" predictor that simply guesses an outcome. 
 pub trait SimplePredictor {
     fn name(&self) -> &'static str;
@@ -1,5 +1,9 @@
 
 use crate::Outcome;
+use crate::predictor::Confidence;
+use crate::heap::HeapSize;
+use crate::checkpoint::SaveState;
+use crate::codec::*;
 
 #[derive(Clone, Copy, Debug)]
 pub struct SaturatingCounterConfig {
@@ -12,7 +16,14 @@ impl SaturatingCounterConfig {
         (self.max_t_state.ilog2() + self.max_n_state.ilog2() + 1)
             as usize
     }
+    /// Largest state of a counter in either direction [so that the state
+    /// and direction fit in a byte, see [SaveState]].
+    pub const MAX_STATE: u8 = 127;
+
     pub fn build(self) -> SaturatingCounter {
+        assert!(self.max_t_state <= Self::MAX_STATE 
+            && self.max_n_state <= Self::MAX_STATE,
+            "saturating counter states must be at most {}", Self::MAX_STATE);
         SaturatingCounter {
             cfg: self,
             state: self.default_state,
@@ -68,6 +79,23 @@ impl SaturatingCounter {
     /// Return the current predicted direction.
     pub fn predict(&self) -> Outcome { self.state }
 
+    /// Return the strength of the current prediction.
+    pub fn strength(&self) -> u8 { self.ctr }
+
+    /// Return the maximum strength for the current predicted direction.
+    pub fn max_strength(&self) -> u8 {
+        match self.state {
+            Outcome::T => self.cfg.max_t_state,
+            Outcome::N => self.cfg.max_n_state,
+        }
+    }
+
+    /// Return the confidence in the current prediction [the strength of 
+    /// the counter relative to its maximum strength].
+    pub fn confidence(&self) -> Confidence {
+        Confidence::from_ratio(self.ctr as usize, self.max_strength() as usize)
+    }
+
     /// Update the state of the counter. 
     pub fn update(&mut self, outcome: Outcome) {
         let prediction = self.predict();
@@ -79,5 +107,30 @@ impl SaturatingCounter {
     }
 }
 
+impl HeapSize for SaturatingCounter {
+    fn heap_bytes(&self) -> usize { 0 }
+}
 
+/// Each counter is packed into a single byte [the direction in the low bit,
+/// see [SaturatingCounterConfig::MAX_STATE]].
+impl SaveState for SaturatingCounter {
+    fn save_state(&self, e: &mut Encoder) {
+        e.put_u8((self.ctr << 1) | self.state as u8);
+    }
 
+    fn restore_state(&mut self, d: &mut Decoder) -> Option<()> {
+        let val = d.get_u8()?;
+        let state = Outcome::from_u32((val & 1) as u32)?;
+        let ctr = val >> 1;
+        let lim = match state {
+            Outcome::T => self.cfg.max_t_state,
+            Outcome::N => self.cfg.max_n_state,
+        };
+        if ctr > lim {
+            return None;
+        }
+        self.state = state;
+        self.ctr = ctr;
+        Some(())
+    }
+}
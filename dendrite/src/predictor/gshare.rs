@@ -1,56 +1,98 @@
 
+use bitvec::prelude::*;
+
 use crate::Outcome;
+use crate::history::*;
 use crate::predictor::*;
 use crate::predictor::counter::*;
+use crate::heap::*;
+use crate::hugepage::*;
+use crate::checkpoint::*;
+use crate::codec::*;
+
+/// A table of [SaturatingCounter] indexed by the program counter XOR'ed
+/// with some number of bits of global history.
+///
+/// See "Combining Branch Predictors" (McFarling, 1993).
+pub struct GsharePredictor {
+    /// Saturating counter configuration
+    cfg: SaturatingCounterConfig,
+
+    /// Table of counters
+    data: Vec<SaturatingCounter>,
+
+    /// Number of entries
+    size: usize,
+
+    /// Number of global history bits used to form an index
+    ghist_bits: usize,
+}
+impl GsharePredictor {
+    pub fn new(size: usize, ghist_bits: usize, cfg: SaturatingCounterConfig)
+        -> Self
+    {
+        assert!(size.is_power_of_two());
+        assert!(ghist_bits != 0 && ghist_bits <= usize::BITS as usize);
+        Self {
+            cfg,
+            data: huge_vec(size, cfg.build()),
+            size,
+            ghist_bits,
+        }
+    }
+
+    /// Return the number of global history bits used to form an index.
+    pub fn ghist_bits(&self) -> usize { self.ghist_bits }
+
+    /// Reset all counters.
+    pub fn reset(&mut self) {
+        self.data.iter_mut().for_each(|c| c.reset());
+    }
+}
+
+impl PredictorTable for GsharePredictor {
+    /// The program counter and global history register
+    type Input<'a> = (usize, &'a HistoryRegister);
+    type Index = usize;
+    type Entry = SaturatingCounter;
+
+    fn size(&self) -> usize { self.size }
+
+    fn get_index(&self, input: (usize, &HistoryRegister)) -> usize {
+        let (pc, ghr) = input;
+        let ghist = ghr.data()[0..self.ghist_bits].load::<usize>();
+
+        // When there are more history bits than index bits, the history is
+        // folded onto the index
+        let index_bits = self.size.trailing_zeros();
+        let mut idx = pc ^ ghist;
+        if index_bits != 0 {
+            let mut rest = ghist.checked_shr(index_bits).unwrap_or(0);
+            while rest != 0 {
+                idx ^= rest;
+                rest = rest.checked_shr(index_bits).unwrap_or(0);
+            }
+        }
+        idx & self.index_mask()
+    }
+
+    fn get_entry(&self, idx: usize) -> &SaturatingCounter {
+        &self.data[idx & self.index_mask()]
+    }
 
-///// A table of [SaturatingCounter] indexed by the program counter. 
-//pub struct SimplePHT { 
-//    /// Saturating counter configuration
-//    cfg: SaturatingCounterConfig,
-//
-//    /// Table of counters
-//    data: Vec<SaturatingCounter>,
-//
-//    /// Number of entries
-//    size: usize,
-//
-//    /// Index function
-//    index_fn: PcIndexFn<Self>,
-//}
-//impl SimplePHT {
-//    pub fn new(size: usize, index_fn: PcIndexFn<Self>,
-//        cfg: SaturatingCounterConfig) -> Self
-//    { 
-//        let data = vec![cfg.build(); size];
-//        Self { 
-//            cfg,
-//            data,
-//            size,
-//            index_fn,
-//        }
-//    }
-//}
-//
-//impl PredictorTable for SimplePHT {
-//    type Input<'a> = usize;
-//    type Index = usize;
-//    type Entry = SaturatingCounter;
-//
-//    fn size(&self) -> usize { self.size }
-//
-//    fn get_index(&self, pc: usize) -> usize { 
-//        (self.index_fn)(self, pc) & self.index_mask()
-//    }
-//
-//    fn get_entry(&self, idx: usize) -> &SaturatingCounter { 
-//        let index = idx & self.index_mask();
-//        &self.data[index]
-//    }
-//
-//    fn get_entry_mut(&mut self, idx: usize) -> &mut SaturatingCounter { 
-//        let index = idx & self.index_mask();
-//        &mut self.data[index]
-//    }
-//}
+    fn get_entry_mut(&mut self, idx: usize) -> &mut SaturatingCounter {
+        let index = idx & self.index_mask();
+        &mut self.data[index]
+    }
+}
 
+impl HeapSize for GsharePredictor {
+    fn heap_bytes(&self) -> usize { self.data.heap_bytes() }
+}
 
+impl SaveState for GsharePredictor {
+    fn save_state(&self, e: &mut Encoder) { self.data.save_state(e) }
+    fn restore_state(&mut self, d: &mut Decoder) -> Option<()> {
+        self.data.restore_state(d)
+    }
+}
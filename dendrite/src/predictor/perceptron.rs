@@ -1,5 +1,11 @@
 
 use crate::Outcome;
+use crate::history::*;
+use crate::predictor::*;
+use crate::heap::*;
+use crate::hugepage::*;
+use crate::checkpoint::*;
+use crate::codec::*;
 
 /// Perceptron [with integer weights]. 
 ///
@@ -57,9 +63,25 @@ impl <const L: usize> Perceptron<L> {
         (res, out)
     }
 
+    /// Return the confidence associated with some output value.
+    ///
+    /// Outputs whose magnitude exceeds the training threshold are considered
+    /// to be fully confident. 
+    pub fn confidence(output: i8) -> Confidence {
+        let magnitude = (output as i16).unsigned_abs() as usize;
+        Confidence::from_ratio(magnitude, Self::THETA as usize)
+    }
+
     /// Given some outcome, adjust the weights. 
     pub fn train(&mut self, input: &[i8], outcome: Outcome) {
-        let (output, prediction) = self.output(&input);
+        let (output, _) = self.output(&input);
+        self.train_output(input, output, outcome);
+    }
+
+    /// Given some outcome and the output previously computed for the same
+    /// input, adjust the weights. 
+    pub fn train_output(&mut self, input: &[i8], output: i8, outcome: Outcome) {
+        let prediction = if output >= 0 { Outcome::T } else { Outcome::N };
         let outcome_val: i8 = Self::outcome_to_val(outcome);
 
         // Training occurs after a misprediction, or when the output value is 
@@ -82,3 +104,86 @@ impl <const L: usize> Perceptron<L> {
     }
 }
 
+/// A table of [Perceptron] indexed by the program counter, using 'L' bits
+/// of global history as input.
+pub struct PerceptronTable<const L: usize> {
+    /// Table of perceptrons
+    data: Vec<Perceptron<L>>,
+
+    /// Number of entries
+    size: usize,
+}
+impl <const L: usize> PerceptronTable<L> {
+    pub fn new(size: usize) -> Self {
+        assert!(size.is_power_of_two());
+        Self {
+            data: huge_vec_with(size, |_| Perceptron::new()),
+            size,
+        }
+    }
+
+    /// Reset all perceptrons.
+    pub fn reset(&mut self) {
+        self.data.iter_mut().for_each(|p| p.reset());
+    }
+
+    /// Convert the most-recent 'L' bits of global history into an input 
+    /// vector for a [Perceptron].
+    pub fn input(ghr: &HistoryRegister) -> [i8; L] {
+        let mut res = [0; L];
+        for (idx, bit) in ghr.data()[0..L].iter().by_vals().enumerate() {
+            res[idx] = if bit { 1 } else { -1 };
+        }
+        res
+    }
+}
+
+impl <const L: usize> PredictorTable for PerceptronTable<L> {
+    type Input<'a> = usize;
+    type Index = usize;
+    type Entry = Perceptron<L>;
+
+    fn size(&self) -> usize { self.size }
+
+    fn get_index(&self, pc: usize) -> usize {
+        pc & self.index_mask()
+    }
+
+    fn get_entry(&self, idx: usize) -> &Perceptron<L> {
+        &self.data[idx & self.index_mask()]
+    }
+
+    fn get_entry_mut(&mut self, idx: usize) -> &mut Perceptron<L> {
+        let index = idx & self.index_mask();
+        &mut self.data[index]
+    }
+}
+
+impl <const L: usize> HeapSize for Perceptron<L> {
+    fn heap_bytes(&self) -> usize { 0 }
+}
+impl <const L: usize> HeapSize for PerceptronTable<L> {
+    fn heap_bytes(&self) -> usize { self.data.heap_bytes() }
+}
+
+impl <const L: usize> SaveState for Perceptron<L> {
+    fn save_state(&self, e: &mut Encoder) {
+        self.weights.iter().for_each(|w| e.put_u8(*w as u8));
+        e.put_u8(self.bias as u8);
+    }
+
+    fn restore_state(&mut self, d: &mut Decoder) -> Option<()> {
+        let raw = d.get_raw(L)?;
+        for (w, b) in self.weights.iter_mut().zip(raw) {
+            *w = *b as i8;
+        }
+        self.bias = d.get_u8()? as i8;
+        Some(())
+    }
+}
+impl <const L: usize> SaveState for PerceptronTable<L> {
+    fn save_state(&self, e: &mut Encoder) { self.data.save_state(e) }
+    fn restore_state(&mut self, d: &mut Decoder) -> Option<()> {
+        self.data.restore_state(d)
+    }
+}
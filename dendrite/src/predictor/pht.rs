@@ -2,6 +2,10 @@
 use crate::Outcome;
 use crate::predictor::*;
 use crate::predictor::counter::*;
+use crate::heap::*;
+use crate::hugepage::*;
+use crate::checkpoint::*;
+use crate::codec::*;
 
 /// A table of [SaturatingCounter] indexed by the program counter. 
 pub struct SimplePHT { 
@@ -21,7 +25,7 @@ impl SimplePHT {
     pub fn new(size: usize, index_fn: PcIndexFn<Self>,
         cfg: SaturatingCounterConfig) -> Self
     { 
-        let data = vec![cfg.build(); size];
+        let data = huge_vec(size, cfg.build());
         Self { 
             cfg,
             data,
@@ -29,6 +33,11 @@ impl SimplePHT {
             index_fn,
         }
     }
+
+    /// Reset all counters.
+    pub fn reset(&mut self) {
+        self.data.iter_mut().for_each(|c| c.reset());
+    }
 }
 
 impl PredictorTable for SimplePHT {
@@ -53,4 +62,13 @@ impl PredictorTable for SimplePHT {
     }
 }
 
+impl HeapSize for SimplePHT {
+    fn heap_bytes(&self) -> usize { self.data.heap_bytes() }
+}
 
+impl SaveState for SimplePHT {
+    fn save_state(&self, e: &mut Encoder) { self.data.save_state(e) }
+    fn restore_state(&mut self, d: &mut Decoder) -> Option<()> {
+        self.data.restore_state(d)
+    }
+}
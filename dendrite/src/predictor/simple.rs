@@ -1,6 +1,9 @@
 
 use crate::Outcome;
 use crate::predictor::SimplePredictor;
+use crate::heap::HeapSize;
+use crate::checkpoint::SaveState;
+use crate::codec::*;
 
 /// A simple predictor with no state: randomly predict an outcome.
 pub struct RandomPredictor;
@@ -23,3 +26,25 @@ impl SimplePredictor for NotTakenPredictor {
     fn predict(&self) -> Outcome { Outcome::N }
 }
 
+impl HeapSize for RandomPredictor {
+    fn heap_bytes(&self) -> usize { 0 }
+}
+impl HeapSize for TakenPredictor {
+    fn heap_bytes(&self) -> usize { 0 }
+}
+impl HeapSize for NotTakenPredictor {
+    fn heap_bytes(&self) -> usize { 0 }
+}
+
+impl SaveState for RandomPredictor {
+    fn save_state(&self, _e: &mut Encoder) {}
+    fn restore_state(&mut self, _d: &mut Decoder) -> Option<()> { Some(()) }
+}
+impl SaveState for TakenPredictor {
+    fn save_state(&self, _e: &mut Encoder) {}
+    fn restore_state(&mut self, _d: &mut Decoder) -> Option<()> { Some(()) }
+}
+impl SaveState for NotTakenPredictor {
+    fn save_state(&self, _e: &mut Encoder) {}
+    fn restore_state(&mut self, _d: &mut Decoder) -> Option<()> { Some(()) }
+}
@@ -2,14 +2,20 @@
 pub mod component;
 pub mod stat;
 pub mod config;
+pub mod preset;
+pub mod log;
 
 pub use component::*;
 pub use stat::*;
 pub use config::*;
+pub use log::*;
 
 use bitvec::prelude::*;
 use rand::distributions::{ WeightedIndex, Distribution };
 
+use crate::checkpoint::*;
+use crate::codec::*;
+use crate::heap::*;
 use crate::history::*;
 use crate::Outcome;
 use crate::predictor::*;
@@ -62,9 +68,47 @@ pub struct TAGEPrediction {
 
     /// The tag matching the entry from the alternate component
     pub alt_tag: usize,
+
+    /// Confidence in the predicted direction
+    pub confidence: Confidence,
 }
 
 
+/// A small deterministic random number generator (xorshift64).
+#[derive(Clone, Debug, PartialEq, Eq)]
+pub struct XorShift64 {
+    state: u64,
+}
+impl XorShift64 {
+    pub fn new(seed: u64) -> Self {
+        // The state must never be zero
+        Self { state: if seed == 0 { 0x9e37_79b9_7f4a_7c15 } else { seed } }
+    }
+
+    pub fn next_u64(&mut self) -> u64 {
+        let mut x = self.state;
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        self.state = x;
+        x
+    }
+
+    /// Select an index with probability proportional to its weight.
+    pub fn weighted_index(&mut self, weights: &[usize]) -> usize {
+        let total: usize = weights.iter().sum();
+        assert!(total != 0);
+        let mut x = (self.next_u64() % total as u64) as usize;
+        for (idx, w) in weights.iter().enumerate() {
+            if x < *w {
+                return idx;
+            }
+            x -= w;
+        }
+        unreachable!()
+    }
+}
+
 /// The "TAgged GEometric history length" predictor. 
 ///
 /// See the following: 
@@ -84,6 +128,13 @@ pub struct TAGEPredictor {
 
     /// Counter used to periodically reset all 'useful' counters
     pub reset_ctr: u8,
+
+    /// Generator used to select between allocation candidates 
+    /// (see [TAGEConfig::alloc_seed])
+    pub alloc_rng: Option<XorShift64>,
+
+    /// Optional log of every update (see [TAGEEventLog])
+    pub log: Option<Box<TAGEEventLog>>,
 }
 impl TAGEPredictor {
 
@@ -114,7 +165,7 @@ impl TAGEPredictor {
     /// allocate a new entry. 
     ///
     /// Returns [None] if we fail to allocate a new entry. 
-    fn alloc(&self, input: TAGEInputs, provider: TAGEProvider) 
+    fn alloc(&mut self, input: TAGEInputs, provider: TAGEProvider) 
         -> Option<usize>
     { 
         // Early return: when the provider is the component with the longest 
@@ -159,9 +210,12 @@ impl TAGEPredictor {
         // with candidates of increasing history length: given candidates with 
         // history lengths J and K (where J < K), the candidate J is twice as 
         // likely to be chosen over K.
-        let mut rng = rand::thread_rng();
         let weights: Vec<usize> = candidates.iter().map(|idx| 1 << idx)
             .collect();
+        if let Some(rng) = self.alloc_rng.as_mut() {
+            return Some(candidates[rng.weighted_index(&weights)]);
+        }
+        let mut rng = rand::thread_rng();
         let dist = WeightedIndex::new(&weights).unwrap();
         Some(candidates[dist.sample(&mut rng)])
     }
@@ -171,7 +225,7 @@ impl TAGEPredictor {
         input: TAGEInputs, 
         prediction: TAGEPrediction, 
         outcome: Outcome
-    )
+    ) -> TAGEAllocation
     {
         // Update the entry in the component that provided the prediction
         match prediction.provider {
@@ -214,12 +268,39 @@ impl TAGEPredictor {
             new_entry.stat.branches.insert(input.pc);
             self.stat.alcs += 1;
             self.reset_ctr = self.reset_ctr.saturating_add(1);
+            TAGEAllocation::Allocated(idx)
         } 
         else { 
             self.stat.failed_alcs += 1;
             self.reset_ctr = self.reset_ctr.saturating_sub(1);
+            TAGEAllocation::Failed
         }
+    }
 
+    /// Append an event to the log.
+    ///
+    /// This is kept out of line so that [TAGEPredictor::update] stays small
+    /// when logging is disabled.
+    #[inline(never)]
+    fn log_event(&mut self, pc: usize, prediction: &TAGEPrediction, 
+        outcome: Outcome, alloc: TAGEAllocation, reset: bool)
+    {
+        let clk = self.stat.clk as u64;
+        let log = self.log.as_mut().unwrap();
+        log.push(&TAGEEvent {
+            clk,
+            pc: pc as u64,
+            provider: prediction.provider,
+            alt_provider: prediction.alt_provider,
+            predicted: prediction.outcome,
+            outcome,
+            alloc,
+            reset,
+            idx: prediction.idx as u32,
+            alt_idx: prediction.alt_idx as u32,
+            tag: prediction.tag as u16,
+            alt_tag: prediction.alt_tag as u16,
+        });
     }
 
     /// Update the predictor to account for a correct prediction.
@@ -253,6 +334,54 @@ impl TAGEPredictor {
 
 }
 
+impl HeapSize for TAGEPredictor {
+    fn heap_bytes(&self) -> usize {
+        self.heap_usage("").bytes
+    }
+
+    fn heap_usage(&self, name: &str) -> HeapUsage {
+        let mut parts = vec![self.base.heap_usage("base component")];
+        for (idx, comp) in self.comp.iter().enumerate() {
+            parts.push(comp.heap_usage(&format!("component[{}]", idx)));
+        }
+        parts.push(HeapUsage::new("stats", self.stat.comp_miss.heap_bytes()));
+        parts.push(HeapUsage::new("event log", self.log.as_ref().map_or(0, 
+            |log| std::mem::size_of::<TAGEEventLog>() + log.heap_bytes())));
+        parts.push(HeapUsage::new("config", self.cfg.comp.capacity() 
+            * std::mem::size_of::<TAGEComponentConfig>()));
+        HeapUsage::from_children(name, parts)
+    }
+}
+
+/// NOTE: When [TAGEConfig::alloc_seed] is not set, allocation uses the 
+/// thread-local generator, so a restored predictor will not make the same
+/// allocation decisions as the original. 
+impl SaveState for TAGEPredictor {
+    fn save_state(&self, e: &mut Encoder) {
+        self.stat.encode(e);
+        self.base.save_state(e);
+        self.comp.save_state(e);
+        e.put_u8(self.reset_ctr);
+        if let Some(rng) = self.alloc_rng.as_ref() {
+            e.put_u64(rng.state);
+        }
+    }
+
+    fn restore_state(&mut self, d: &mut Decoder) -> Option<()> {
+        self.stat = TAGEStats::decode(d)?;
+        self.base.restore_state(d)?;
+        self.comp.restore_state(d)?;
+        self.reset_ctr = d.get_u8()?;
+        if let Some(rng) = self.alloc_rng.as_mut() {
+            rng.state = d.get_u64()?;
+            if rng.state == 0 {
+                return None;
+            }
+        }
+        Some(())
+    }
+}
+
 /// The public interface to a [TAGEPredictor].
 impl TAGEPredictor {
     /// Return the number of tagged components.
@@ -283,7 +412,8 @@ impl TAGEPredictor {
             alt_provider: TAGEProvider::Base,
             alt_outcome: default_outcome,
             alt_idx: base_idx,
-            alt_tag: 0
+            alt_tag: 0,
+            confidence: base_entry.confidence(),
         };
 
         // NOTE: You're iterating through components *backwards* here 
@@ -300,6 +430,7 @@ impl TAGEPredictor {
                 result.outcome  = entry.predict();
                 result.idx = *entry_idx;
                 result.tag = *tag; 
+                result.confidence = entry.confidence();
             }
         }
         result
@@ -313,15 +444,17 @@ impl TAGEPredictor {
         outcome: Outcome
     )
     {
-        if prediction.outcome != outcome {
-            self.update_incorrect(input.clone(), prediction, outcome);
+        let alloc = if prediction.outcome != outcome {
+            self.update_incorrect(input.clone(), prediction, outcome)
         } else {
             self.update_correct(input.clone(), prediction, outcome);
-        }
+            TAGEAllocation::None
+        };
 
         // Periodically reset *all* of the 'useful' counters across all 
         // tagged components. 
-        if self.reset_ctr == u8::MAX {
+        let reset = self.reset_ctr == u8::MAX;
+        if reset {
             self.reset_ctr = 0;
             self.stat.resets += 1;
             for comp in self.comp.iter_mut() {
@@ -329,9 +462,23 @@ impl TAGEPredictor {
             }
         }
 
+        if self.log.is_some() {
+            self.log_event(input.pc, &prediction, outcome, alloc, reset);
+        }
+
         self.stat.clk += 1;
     }
 
+    /// Return the predictor to the state it was built in [including
+    /// statistics], without reallocating any tables.
+    pub fn reset(&mut self) {
+        self.base.data.iter_mut().for_each(|c| c.reset());
+        self.comp.iter_mut().for_each(|c| c.reset());
+        self.stat = TAGEStats::new(self.comp.len());
+        self.reset_ctr = 0;
+        self.alloc_rng = self.cfg.alloc_seed.map(XorShift64::new);
+    }
+
     /// Given some reference to a [HistoryRegister], update the state
     /// of the folded history register in each tagged component. 
     pub fn update_history(&mut self, ghr: &HistoryRegister) {
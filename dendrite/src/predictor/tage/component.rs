@@ -1,5 +1,8 @@
 
 use crate::Outcome;
+use crate::checkpoint::*;
+use crate::codec::*;
+use crate::heap::*;
 use crate::history::*;
 use crate::predictor::*;
 use std::ops::RangeInclusive;
@@ -97,6 +100,18 @@ impl TAGEEntry {
         self.stat.updates += 1;
     }
 
+    /// Return the confidence in the current prediction.
+    ///
+    /// This combines the strength of the counter with the 'useful' counter:
+    /// an entry that is both saturated and useful is fully confident. 
+    pub fn confidence(&self) -> Confidence {
+        let max_useful = (1 << self.useful_bits) - 1;
+        Confidence::from_ratio(
+            self.ctr.strength() as usize + self.useful as usize,
+            self.ctr.max_strength() as usize + max_useful,
+        )
+    }
+
     /// Returns true if the provided tag matches this entry. 
     pub fn tag_matches(&self, tag: usize) -> bool { 
         if let Some(val) = self.tag { val == tag } else { false }
@@ -138,6 +153,10 @@ impl TAGEComponent {
         self.data.iter().filter(|e| e.useful != 0).count()
     }
 
+    pub fn num_valid_entries(&self) -> usize { 
+        self.data.iter().filter(|e| e.tag.is_some()).count()
+    }
+
     /// Calculate what percentage of entries have been allocated. 
     pub fn utilization(&self) -> f64 { 
         let unused_entries = self.data.iter().filter(|e| e.stat.was_unused())
@@ -145,6 +164,13 @@ impl TAGEComponent {
         (1.0 - (unused_entries / self.data.len() as f64)) * 100.0
     }
 
+    /// Invalidate all entries and clear the folded history.
+    pub fn reset(&mut self) {
+        let entry = TAGEEntry::new(self.cfg.ctr.build(), self.cfg.useful_bits);
+        self.data.iter_mut().for_each(|e| *e = entry.clone());
+        self.csr.reset();
+    }
+
     /// Reset the 'useful' counter for all entries in this component.
     pub fn reset_useful_bits(&mut self) {
         for entry in self.data.iter_mut() {
@@ -204,3 +230,64 @@ impl <'a> TaggedPredictorTable<'a> for TAGEComponent {
     }
 }
 
+impl HeapSize for TAGEBaseComponent {
+    fn heap_bytes(&self) -> usize { self.data.heap_bytes() }
+}
+
+impl HeapSize for TAGEEntry {
+    fn heap_bytes(&self) -> usize { self.stat.heap_bytes() }
+}
+
+impl HeapSize for TAGEComponent {
+    fn heap_bytes(&self) -> usize {
+        self.heap_usage("").bytes
+    }
+
+    /// Separate the table itself from the [TAGEEntryStats] kept for each 
+    /// entry (which are not part of the modeled hardware).
+    fn heap_usage(&self, name: &str) -> HeapUsage {
+        let stats: usize = self.data.iter().map(|e| e.heap_bytes()).sum();
+        HeapUsage::from_children(name, vec![
+            HeapUsage::new("table", 
+                self.data.capacity() * std::mem::size_of::<TAGEEntry>()),
+            HeapUsage::new("entry stats", stats),
+            HeapUsage::new("folded history", self.csr.heap_bytes()),
+        ])
+    }
+}
+
+impl SaveState for TAGEBaseComponent {
+    fn save_state(&self, e: &mut Encoder) { self.data.save_state(e) }
+    fn restore_state(&mut self, d: &mut Decoder) -> Option<()> {
+        self.data.restore_state(d)
+    }
+}
+
+impl SaveState for TAGEEntry {
+    fn save_state(&self, e: &mut Encoder) {
+        self.ctr.save_state(e);
+        e.put_u8(self.useful);
+        e.put_usize(self.tag.map(|t| t + 1).unwrap_or(0));
+        self.stat.encode(e);
+    }
+
+    fn restore_state(&mut self, d: &mut Decoder) -> Option<()> {
+        self.ctr.restore_state(d)?;
+        self.useful = d.get_u8()?;
+        self.tag = d.get_usize()?.checked_sub(1);
+        self.stat = TAGEEntryStats::decode(d)?;
+        Some(())
+    }
+}
+
+impl SaveState for TAGEComponent {
+    fn save_state(&self, e: &mut Encoder) {
+        self.data.save_state(e);
+        self.csr.save_state(e);
+    }
+
+    fn restore_state(&mut self, d: &mut Decoder) -> Option<()> {
+        self.data.restore_state(d)?;
+        self.csr.restore_state(d)
+    }
+}
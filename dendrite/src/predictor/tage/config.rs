@@ -1,4 +1,5 @@
 
+use crate::hugepage::*;
 use crate::predictor::*;
 use std::ops::RangeInclusive;
 
@@ -24,7 +25,7 @@ impl TAGEBaseConfig {
     pub fn build(self) -> TAGEBaseComponent {
         assert!(self.size.is_power_of_two());
         TAGEBaseComponent {
-            data: vec![self.ctr.build(); self.size],
+            data: huge_vec(self.size, self.ctr.build()),
             cfg: self,
         }
     }
@@ -73,7 +74,7 @@ impl TAGEComponentConfig {
             self.ghr_range.clone()
         );
         let entry = TAGEEntry::new(self.ctr.build(), self.useful_bits);
-        let data = vec![entry; self.size];
+        let data = huge_vec(self.size, entry);
 
         TAGEComponent {
             cfg: self,
@@ -92,12 +93,18 @@ pub struct TAGEConfig {
 
     /// Tagged component configurations
     pub comp: Vec<TAGEComponentConfig>,
+
+    /// Seed used to select between allocation candidates. 
+    /// When [None], allocation uses the thread-local random generator and 
+    /// results are not reproducible.
+    pub alloc_seed: Option<u64>,
 }
 impl TAGEConfig {
     pub fn new(base: TAGEBaseConfig) -> Self {
         Self {
             base,
             comp: Vec::new(),
+            alloc_seed: None,
         }
     }
 
@@ -129,12 +136,15 @@ impl TAGEConfig {
             .collect::<Vec<TAGEComponent>>();
         let base = self.base.build();
         let stat = TAGEStats::new(comp.len());
+        let alloc_rng = self.alloc_seed.map(XorShift64::new);
         TAGEPredictor { 
             cfg, 
             base, 
             comp, 
             stat, 
             reset_ctr: 0,
+            alloc_rng,
+            log: None,
         }
     }
 }
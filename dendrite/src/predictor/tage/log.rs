@@ -0,0 +1,329 @@
+
+use std::collections::*;
+use std::fs::File;
+use std::io::{ BufReader, BufWriter, Read, Write };
+use crate::Outcome;
+use crate::heap::*;
+use crate::hugepage::*;
+use crate::predictor::*;
+
+/// The result of trying to allocate a new entry after a misprediction.
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum TAGEAllocation {
+    /// No allocation was attempted [the prediction was correct]
+    None,
+
+    /// Allocation failed
+    Failed,
+
+    /// An entry was allocated in some tagged component
+    Allocated(usize),
+}
+
+/// A record of a single prediction and update made by a [TAGEPredictor].
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub struct TAGEEvent {
+    /// Number of predictor updates before this one [ie. the index of this
+    /// branch among all conditional branches]
+    pub clk: u64,
+
+    pub pc: u64,
+    pub provider: TAGEProvider,
+    pub alt_provider: TAGEProvider,
+
+    /// Predicted direction
+    pub predicted: Outcome,
+
+    /// Resolved direction
+    pub outcome: Outcome,
+
+    pub alloc: TAGEAllocation,
+
+    /// Whether all 'useful' counters were reset after this update
+    pub reset: bool,
+
+    pub idx: u32,
+    pub alt_idx: u32,
+    pub tag: u16,
+    pub alt_tag: u16,
+}
+impl TAGEEvent {
+    /// Size of an encoded event [in bytes].
+    pub const SIZE: usize = 32;
+
+    fn encode_provider(p: TAGEProvider) -> u8 {
+        match p {
+            TAGEProvider::Base => 0,
+            TAGEProvider::Tagged(idx) => 1 + idx as u8,
+        }
+    }
+
+    fn decode_provider(x: u8) -> TAGEProvider {
+        match x {
+            0 => TAGEProvider::Base,
+            x => TAGEProvider::Tagged(x as usize - 1),
+        }
+    }
+
+    /// Encode this event into a fixed-size buffer.
+    pub fn encode(&self) -> [u8; Self::SIZE] {
+        let mut res = [0u8; Self::SIZE];
+        res[0..8].copy_from_slice(&self.clk.to_le_bytes());
+        res[8..16].copy_from_slice(&self.pc.to_le_bytes());
+        res[16] = Self::encode_provider(self.provider);
+        res[17] = Self::encode_provider(self.alt_provider);
+        res[18] = self.predicted as u8
+            | (self.outcome as u8) << 1
+            | (self.reset as u8) << 2;
+        res[19] = match self.alloc {
+            TAGEAllocation::None => 0,
+            TAGEAllocation::Failed => 0xff,
+            TAGEAllocation::Allocated(idx) => 1 + idx as u8,
+        };
+        res[20..24].copy_from_slice(&self.idx.to_le_bytes());
+        res[24..28].copy_from_slice(&self.alt_idx.to_le_bytes());
+        res[28..30].copy_from_slice(&self.tag.to_le_bytes());
+        res[30..32].copy_from_slice(&self.alt_tag.to_le_bytes());
+        res
+    }
+
+    pub fn decode(b: &[u8]) -> Self {
+        let word = |off: usize| {
+            u64::from_le_bytes(b[off..off+8].try_into().unwrap())
+        };
+        let half = |off: usize| {
+            u32::from_le_bytes(b[off..off+4].try_into().unwrap())
+        };
+        let quarter = |off: usize| {
+            u16::from_le_bytes(b[off..off+2].try_into().unwrap())
+        };
+        Self {
+            clk: word(0),
+            pc: word(8),
+            provider: Self::decode_provider(b[16]),
+            alt_provider: Self::decode_provider(b[17]),
+            predicted: Outcome::from_u32((b[18] & 1) as u32).unwrap(),
+            outcome: Outcome::from_u32((b[18] >> 1 & 1) as u32).unwrap(),
+            reset: b[18] & 4 != 0,
+            alloc: match b[19] {
+                0 => TAGEAllocation::None,
+                0xff => TAGEAllocation::Failed,
+                x => TAGEAllocation::Allocated(x as usize - 1),
+            },
+            idx: half(20),
+            alt_idx: half(24),
+            tag: quarter(28),
+            alt_tag: quarter(30),
+        }
+    }
+
+    pub fn is_miss(&self) -> bool { self.predicted != self.outcome }
+}
+impl std::fmt::Display for TAGEEvent {
+    fn fmt(&self, f: &mut std::fmt::Formatter) -> std::fmt::Result {
+        let prov = |p: TAGEProvider| match p {
+            TAGEProvider::Base => "base".to_string(),
+            TAGEProvider::Tagged(idx) => format!("t{}", idx),
+        };
+        write!(f, "{:10} {:016x} {:?}/{:?} {:4} idx={:04x} tag={:02x} \
+            alt={:4} idx={:04x} tag={:02x}",
+            self.clk, self.pc, self.predicted, self.outcome,
+            prov(self.provider), self.idx, self.tag,
+            prov(self.alt_provider), self.alt_idx, self.alt_tag)?;
+        match self.alloc {
+            TAGEAllocation::None => {},
+            TAGEAllocation::Failed => write!(f, " alloc=failed")?,
+            TAGEAllocation::Allocated(idx) => write!(f, " alloc=t{}", idx)?,
+        }
+        if self.reset {
+            write!(f, " reset")?;
+        }
+        Ok(())
+    }
+}
+
+/// Collects [TAGEEvent]s from a [TAGEPredictor] (see [TAGEPredictor::log]).
+///
+/// Events are written into a preallocated buffer of encoded events. When
+/// streaming to a file, the buffer is written out each time it becomes
+/// full. Otherwise, the buffer is a ring which keeps the most recent
+/// events (ie. to be written with [TAGEEventLog::dump] after something
+/// interesting happens).
+///
+/// The file format is a header ([TAGEEventLog::MAGIC] and the size of each
+/// event as a 32-bit little-endian value) followed by the encoded events.
+pub struct TAGEEventLog {
+    /// Buffer of encoded events
+    buf: Vec<u8>,
+
+    /// Capacity of the buffer [in events]
+    capacity: usize,
+
+    /// Number of events in the buffer
+    len: usize,
+
+    /// Index of the next event in the buffer
+    head: usize,
+
+    /// Output file for streaming events
+    out: Option<BufWriter<File>>,
+
+    /// The first error from writing to the output file [returned by the
+    /// next call to [TAGEEventLog::flush]]
+    err: Option<std::io::Error>,
+
+    /// Total number of events
+    pub num_events: u64,
+}
+impl TAGEEventLog {
+    pub const MAGIC: &'static [u8] = b"DTEV";
+
+    fn new(capacity: usize, out: Option<BufWriter<File>>) -> Self {
+        assert!(capacity != 0);
+        Self {
+            buf: huge_vec(capacity * TAGEEvent::SIZE, 0),
+            capacity,
+            len: 0,
+            head: 0,
+            out,
+            err: None,
+            num_events: 0,
+        }
+    }
+
+    /// Keep the most recent 'capacity' events in memory.
+    pub fn ring(capacity: usize) -> Self {
+        Self::new(capacity, None)
+    }
+
+    /// Stream all events to a file [buffering 'capacity' events at a time].
+    pub fn to_file(path: &str, capacity: usize) -> std::io::Result<Self> {
+        let mut out = BufWriter::new(File::create(path)?);
+        Self::write_header(&mut out)?;
+        Ok(Self::new(capacity, Some(out)))
+    }
+
+    fn write_header(out: &mut impl Write) -> std::io::Result<()> {
+        out.write_all(Self::MAGIC)?;
+        out.write_all(&(TAGEEvent::SIZE as u32).to_le_bytes())
+    }
+
+    #[inline]
+    pub fn push(&mut self, event: &TAGEEvent) {
+        let off = self.head * TAGEEvent::SIZE;
+        self.buf[off..off + TAGEEvent::SIZE].copy_from_slice(&event.encode());
+        self.head = (self.head + 1) % self.capacity;
+        self.len = (self.len + 1).min(self.capacity);
+        self.num_events += 1;
+        if self.head == 0 && self.out.is_some() && self.err.is_none() {
+            if let Err(e) = self.write_buffer() {
+                self.err = Some(e);
+            }
+        }
+    }
+
+    /// Return the events in the buffer [from oldest to newest].
+    pub fn events(&self) -> Vec<TAGEEvent> {
+        let start = (self.head + self.capacity - self.len) % self.capacity;
+        (0..self.len).map(|idx| {
+            let off = ((start + idx) % self.capacity) * TAGEEvent::SIZE;
+            TAGEEvent::decode(&self.buf[off..off + TAGEEvent::SIZE])
+        }).collect()
+    }
+
+    /// Write the events in the buffer to the output file.
+    ///
+    /// If writing failed while streaming, nothing else is written and the
+    /// error is returned here [so that a full disk doesn't stop the
+    /// evaluation].
+    pub fn flush(&mut self) -> std::io::Result<()> {
+        match self.err.take() {
+            Some(e) => Err(e),
+            None => self.write_buffer(),
+        }
+    }
+
+    fn write_buffer(&mut self) -> std::io::Result<()> {
+        if let Some(out) = self.out.as_mut() {
+            let start = (self.head + self.capacity - self.len) % self.capacity;
+            assert!(start == 0 || self.head == 0);
+            let off = start * TAGEEvent::SIZE;
+            out.write_all(&self.buf[off..off + self.len * TAGEEvent::SIZE])?;
+            out.flush()?;
+            self.len = 0;
+            self.head = 0;
+        }
+        Ok(())
+    }
+
+    /// Write the events in the buffer to a new file.
+    pub fn dump(&self, path: &str) -> std::io::Result<()> {
+        let mut out = BufWriter::new(File::create(path)?);
+        Self::write_header(&mut out)?;
+        for event in self.events() {
+            out.write_all(&event.encode())?;
+        }
+        out.flush()
+    }
+}
+
+/// Includes the event buffer and the buffer for the output file.
+impl HeapSize for TAGEEventLog {
+    fn heap_bytes(&self) -> usize {
+        self.buf.heap_bytes() 
+            + self.out.as_ref().map_or(0, |out| out.capacity())
+    }
+}
+
+/// Reads [TAGEEvent]s from a file written by [TAGEEventLog].
+pub struct TAGEEventReader {
+    inp: BufReader<File>,
+}
+impl TAGEEventReader {
+    pub fn open(path: &str) -> std::io::Result<Self> {
+        let mut inp = BufReader::new(File::open(path)?);
+        let mut hdr = [0u8; 8];
+        inp.read_exact(&mut hdr)?;
+        let size = u32::from_le_bytes(hdr[4..8].try_into().unwrap());
+        if &hdr[0..4] != TAGEEventLog::MAGIC || size as usize != TAGEEvent::SIZE {
+            return Err(std::io::Error::new(std::io::ErrorKind::InvalidData,
+                "not a TAGE event log"));
+        }
+        Ok(Self { inp })
+    }
+}
+impl Iterator for TAGEEventReader {
+    type Item = TAGEEvent;
+    fn next(&mut self) -> Option<TAGEEvent> {
+        let mut buf = [0u8; TAGEEvent::SIZE];
+        self.inp.read_exact(&mut buf).ok()?;
+        Some(TAGEEvent::decode(&buf))
+    }
+}
+
+/// Summary of the events for a single branch.
+#[derive(Clone, Debug, Default)]
+pub struct TAGEEventSummary {
+    pub events: usize,
+    pub misses: usize,
+    pub allocs: usize,
+    pub failed_allocs: usize,
+
+    /// Number of predictions from the base component and each tagged
+    /// component
+    pub providers: BTreeMap<u8, usize>,
+}
+impl TAGEEventSummary {
+    pub fn add(&mut self, event: &TAGEEvent) {
+        self.events += 1;
+        self.misses += event.is_miss() as usize;
+        match event.alloc {
+            TAGEAllocation::Allocated(_) => self.allocs += 1,
+            TAGEAllocation::Failed => self.failed_allocs += 1,
+            TAGEAllocation::None => {},
+        }
+        let prov = TAGEEvent::encode_provider(event.provider);
+        *self.providers.entry(prov).or_insert(0) += 1;
+    }
+}
+
@@ -0,0 +1,73 @@
+
+use bitvec::prelude::*;
+
+use crate::history::*;
+use crate::Outcome;
+use crate::predictor::*;
+
+/// Index function into the base component.
+fn tage_base_fold_pc_12b(comp: &TAGEBaseComponent, pc: usize) -> usize { 
+    fold_pc_12b(pc)
+}
+
+/// Index function into a tagged component. 
+/// - 12 bits from the folded program counter value
+/// - 12 bits from the path history register
+/// - 12 bits from the folded global history register
+fn tage_fold_phr_ghist_12b(comp: &TAGEComponent, 
+    pc: usize, phr: &HistoryRegister) -> usize
+{
+    let pc_bits = fold_pc_12b(pc);
+    let phr_bits = phr.data()[0..=11].load::<usize>() & 0b1111_1111_1110;
+
+    let ghist_bits = comp.csr.output_usize(); 
+    ghist_bits ^ pc_bits ^ phr_bits
+
+}
+
+/// Hash function for computing a tag.
+fn tage_compute_tag(comp: &TAGEComponent, pc: usize) -> usize { 
+    let pc_bits = fold_pc_12b(pc);
+    let ghist0_bits = comp.csr.output_usize();
+    let ghist1_bits = comp.csr.output_usize() << 1;
+    (pc_bits ^ ghist0_bits ^ ghist1_bits) & ((1 << comp.cfg.tag_bits) -1)
+}
+
+impl TAGEConfig {
+    /// A configuration with a 4096-entry base component and five 4096-entry
+    /// tagged components (using 8, 16, 32, 64, and 128 bits of global 
+    /// history). Tagged components are indexed with 12 bits of path history,
+    /// which is expected to be updated with [update_phr].
+    pub fn preset_default() -> Self {
+        let mut tage_cfg = TAGEConfig::new(
+            TAGEBaseConfig { 
+                ctr: SaturatingCounterConfig {
+                    max_t_state: 2,
+                    max_n_state: 2,
+                    default_state: Outcome::N,
+                },
+                size: 1 << 12,
+                index_strat: IndexStrategy::FromPc(tage_base_fold_pc_12b),
+            },
+        );
+
+        for ghr_range_hi in &[7, 15, 31, 63, 127] {
+            tage_cfg.add_component(
+                TAGEComponentConfig {
+                    size: 1 << 12,
+                    ghr_range: 0..=*ghr_range_hi,
+                    tag_bits: 8,
+                    useful_bits: 1,
+                    ctr: SaturatingCounterConfig {
+                        max_t_state: 1,
+                        max_n_state: 1,
+                        default_state: Outcome::N,
+                    },
+                    index_strat: IndexStrategy::FromPhr(tage_fold_phr_ghist_12b),
+                    tag_strat: TagStrategy::FromPc(tage_compute_tag),
+            });
+        }
+        tage_cfg
+    }
+}
+
@@ -1,8 +1,11 @@
 
 use std::collections::*;
+use crate::codec::*;
+use crate::heap::*;
+use crate::stats::Merge;
 
 /// Container for [TAGEPredictor] runtime stats.
-#[derive(Debug)]
+#[derive(Clone, Debug, PartialEq, Eq)]
 pub struct TAGEStats {
     /// Successful allocations
     pub alcs: usize,
@@ -35,6 +38,42 @@ impl TAGEStats {
     }
 }
 
+impl Merge for TAGEStats {
+    fn merge(&mut self, other: &Self) {
+        assert!(self.comp_miss.len() == other.comp_miss.len());
+        self.alcs += other.alcs;
+        self.failed_alcs += other.failed_alcs;
+        self.base_miss += other.base_miss;
+        for (x, y) in self.comp_miss.iter_mut().zip(other.comp_miss.iter()) {
+            *x += *y;
+        }
+        self.resets += other.resets;
+        self.clk += other.clk;
+    }
+}
+
+impl Codec for TAGEStats {
+    fn encode(&self, e: &mut Encoder) {
+        e.put_usize(self.alcs);
+        e.put_usize(self.failed_alcs);
+        e.put_usize(self.base_miss);
+        e.put_slice(&self.comp_miss);
+        e.put_usize(self.resets);
+        e.put_usize(self.clk);
+    }
+
+    fn decode(d: &mut Decoder) -> Option<Self> {
+        Some(Self {
+            alcs: d.get_usize()?,
+            failed_alcs: d.get_usize()?,
+            base_miss: d.get_usize()?,
+            comp_miss: d.get_vec()?,
+            resets: d.get_usize()?,
+            clk: d.get_usize()?,
+        })
+    }
+}
+
 /// Container for [TAGEEntry] runtime stats.
 #[derive(Clone, Debug)]
 pub struct TAGEEntryStats {
@@ -71,4 +110,36 @@ impl TAGEEntryStats {
 
 }
 
+impl HeapSize for TAGEEntryStats {
+    fn heap_bytes(&self) -> usize { self.branches.heap_bytes() }
+}
+
+impl Codec for TAGEEntryStats {
+    // The set of branches is sorted, so we only need to write the 
+    // difference between consecutive values.
+    fn encode(&self, e: &mut Encoder) {
+        e.put_usize(self.updates);
+        e.put_usize(self.invalidations);
+        e.put_usize(self.branches.len());
+        let mut prev_pc = 0;
+        for pc in self.branches.iter() {
+            e.put_usize(pc - prev_pc);
+            prev_pc = *pc;
+        }
+        e.put_usize(self.clk);
+    }
 
+    fn decode(d: &mut Decoder) -> Option<Self> {
+        let mut res = Self::new();
+        res.updates = d.get_usize()?;
+        res.invalidations = d.get_usize()?;
+        let len = d.get_usize()?;
+        let mut pc = 0usize;
+        for _ in 0..len {
+            pc = pc.checked_add(d.get_usize()?)?;
+            res.branches.insert(pc);
+        }
+        res.clk = d.get_usize()?;
+        Some(res)
+    }
+}
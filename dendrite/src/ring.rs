@@ -0,0 +1,289 @@
+//! Ring buffers for passing preallocated data between threads.
+
+use std::cell::UnsafeCell;
+use std::sync::atomic::{ AtomicBool, AtomicUsize, Ordering };
+
+/// Wait for another thread to make progress.
+///
+/// Spins for a short while before yielding to the scheduler.
+fn backoff(spins: &mut usize) {
+    if *spins < 64 {
+        std::hint::spin_loop();
+    } else {
+        std::thread::yield_now();
+    }
+    *spins += 1;
+}
+
+/// A lock-free single-producer, single-consumer ring of preallocated slots.
+///
+/// Slots are never moved in or out of the ring: the producer fills a slot 
+/// in-place, and the consumer reads it in-place before returning it to the
+/// producer. Use [SpscRing::split] to obtain the two ends of the ring.
+pub struct SpscRing<T> {
+    slots: Box<[UnsafeCell<T>]>,
+
+    /// Number of slots released by the consumer
+    head: AtomicUsize,
+
+    /// Number of slots published by the producer
+    tail: AtomicUsize,
+
+    /// Set when the producer is finished
+    closed: AtomicBool,
+
+    /// Set when the consumer is dropped
+    poisoned: AtomicBool,
+}
+unsafe impl <T: Send> Sync for SpscRing<T> {}
+impl <T> SpscRing<T> {
+    /// Create a ring with 'size' slots, each initialized with 'init'.
+    pub fn new(size: usize, mut init: impl FnMut() -> T) -> Self {
+        assert!(size != 0);
+        Self {
+            slots: (0..size).map(|_| UnsafeCell::new(init())).collect(),
+            head: AtomicUsize::new(0),
+            tail: AtomicUsize::new(0),
+            closed: AtomicBool::new(false),
+            poisoned: AtomicBool::new(false),
+        }
+    }
+
+    pub fn capacity(&self) -> usize { self.slots.len() }
+
+    /// Reset the ring and return the producer and consumer ends. 
+    pub fn split(&mut self) -> (RingProducer<'_, T>, RingConsumer<'_, T>) {
+        *self.head.get_mut() = 0;
+        *self.tail.get_mut() = 0;
+        *self.closed.get_mut() = false;
+        *self.poisoned.get_mut() = false;
+        (RingProducer { ring: self }, RingConsumer { ring: self })
+    }
+}
+
+/// The producer end of a [SpscRing].
+///
+/// The ring is closed when the producer is dropped. 
+pub struct RingProducer<'a, T> {
+    ring: &'a SpscRing<T>,
+}
+impl <'a, T> RingProducer<'a, T> {
+    /// Wait for a free slot, fill it with 'f', and publish it.
+    ///
+    /// Returns [None] without calling 'f' if the consumer has been dropped
+    /// (ie. because the consuming thread panicked), since no slots will
+    /// ever be released.
+    pub fn write<R>(&mut self, f: impl FnOnce(&mut T) -> R) -> Option<R> {
+        let ring = self.ring;
+        let tail = ring.tail.load(Ordering::Relaxed);
+        let mut spins = 0;
+        loop {
+            if ring.poisoned.load(Ordering::Acquire) {
+                return None;
+            }
+            if tail - ring.head.load(Ordering::Acquire) != ring.capacity() {
+                break;
+            }
+            backoff(&mut spins);
+        }
+        // The consumer has released this slot, and won't touch it again
+        // until we advance the tail. 
+        let slot = unsafe { &mut *ring.slots[tail % ring.capacity()].get() };
+        let res = f(slot);
+        ring.tail.store(tail + 1, Ordering::Release);
+        Some(res)
+    }
+}
+impl <'a, T> Drop for RingProducer<'a, T> {
+    fn drop(&mut self) {
+        self.ring.closed.store(true, Ordering::Release);
+    }
+}
+
+/// The consumer end of a [SpscRing].
+///
+/// The producer stops waiting for free slots when the consumer is dropped.
+pub struct RingConsumer<'a, T> {
+    ring: &'a SpscRing<T>,
+}
+impl <'a, T> RingConsumer<'a, T> {
+    /// Wait for the next published slot, read it with 'f', and return it 
+    /// to the producer. Returns [None] when the producer is finished and
+    /// all slots have been read.
+    pub fn read<R>(&mut self, f: impl FnOnce(&T) -> R) -> Option<R> {
+        let ring = self.ring;
+        let head = ring.head.load(Ordering::Relaxed);
+        let mut spins = 0;
+        while ring.tail.load(Ordering::Acquire) == head {
+            // Check the tail again, since the producer may have published
+            // a slot before closing the ring
+            if ring.closed.load(Ordering::Acquire) {
+                if ring.tail.load(Ordering::Acquire) == head {
+                    return None;
+                }
+                break;
+            }
+            backoff(&mut spins);
+        }
+        let slot = unsafe { &*ring.slots[head % ring.capacity()].get() };
+        let res = f(slot);
+        ring.head.store(head + 1, Ordering::Release);
+        Some(res)
+    }
+}
+impl <'a, T> Drop for RingConsumer<'a, T> {
+    fn drop(&mut self) {
+        self.ring.poisoned.store(true, Ordering::Release);
+    }
+}
+
+/// A lock-free ring of preallocated slots with a single producer and many
+/// consumers, where every consumer reads every slot.
+///
+/// Each slot has a reference count which is set to the number of consumers
+/// when the slot is published. Consumers read slots at their own pace and
+/// release each slot after reading it; the producer only reuses a slot 
+/// after every consumer has released it. Use [BroadcastRing::split] to 
+/// obtain the producer and consumer ends of the ring.
+pub struct BroadcastRing<T> {
+    slots: Box<[UnsafeCell<T>]>,
+
+    /// Number of consumers still reading each slot
+    refs: Box<[AtomicUsize]>,
+
+    /// Number of slots published by the producer
+    tail: AtomicUsize,
+
+    /// Set when the producer is finished
+    closed: AtomicBool,
+
+    /// Set when a consumer is dropped before reading every slot
+    poisoned: AtomicBool,
+
+    /// Number of consumers
+    num_consumers: usize,
+}
+unsafe impl <T: Send + Sync> Sync for BroadcastRing<T> {}
+impl <T> BroadcastRing<T> {
+    /// Create a ring with 'size' slots, each initialized with 'init'.
+    pub fn new(size: usize, mut init: impl FnMut() -> T) -> Self {
+        assert!(size != 0);
+        Self {
+            slots: (0..size).map(|_| UnsafeCell::new(init())).collect(),
+            refs: (0..size).map(|_| AtomicUsize::new(0)).collect(),
+            tail: AtomicUsize::new(0),
+            closed: AtomicBool::new(false),
+            poisoned: AtomicBool::new(false),
+            num_consumers: 0,
+        }
+    }
+
+    pub fn capacity(&self) -> usize { self.slots.len() }
+
+    /// Reset the ring and return the producer end, along with 
+    /// 'num_consumers' consumer ends.
+    pub fn split(&mut self, num_consumers: usize) 
+        -> (BroadcastProducer<'_, T>, Vec<BroadcastConsumer<'_, T>>)
+    {
+        assert!(num_consumers != 0);
+        self.refs.iter_mut().for_each(|r| *r.get_mut() = 0);
+        *self.tail.get_mut() = 0;
+        *self.closed.get_mut() = false;
+        *self.poisoned.get_mut() = false;
+        self.num_consumers = num_consumers;
+
+        let ring = &*self;
+        let consumers = (0..num_consumers)
+            .map(|_| BroadcastConsumer { ring, pos: 0, done: false })
+            .collect();
+        (BroadcastProducer { ring }, consumers)
+    }
+}
+
+/// The producer end of a [BroadcastRing].
+///
+/// The ring is closed when the producer is dropped. 
+pub struct BroadcastProducer<'a, T> {
+    ring: &'a BroadcastRing<T>,
+}
+impl <'a, T> BroadcastProducer<'a, T> {
+    /// Wait until the next slot has been released by all consumers, fill 
+    /// it with 'f', and publish it.
+    ///
+    /// Returns [None] without calling 'f' if any consumer has been dropped
+    /// before reading every slot (ie. because the consuming thread
+    /// panicked), since its slots will never be released.
+    pub fn write<R>(&mut self, f: impl FnOnce(&mut T) -> R) -> Option<R> {
+        let ring = self.ring;
+        let tail = ring.tail.load(Ordering::Relaxed);
+        let idx = tail % ring.capacity();
+        let mut spins = 0;
+        loop {
+            if ring.poisoned.load(Ordering::Acquire) {
+                return None;
+            }
+            if ring.refs[idx].load(Ordering::Acquire) == 0 {
+                break;
+            }
+            backoff(&mut spins);
+        }
+        // No consumer will touch this slot until we advance the tail.
+        let slot = unsafe { &mut *ring.slots[idx].get() };
+        let res = f(slot);
+        ring.refs[idx].store(ring.num_consumers, Ordering::Relaxed);
+        ring.tail.store(tail + 1, Ordering::Release);
+        Some(res)
+    }
+}
+impl <'a, T> Drop for BroadcastProducer<'a, T> {
+    fn drop(&mut self) {
+        self.ring.closed.store(true, Ordering::Release);
+    }
+}
+
+/// A consumer end of a [BroadcastRing].
+///
+/// Dropping a consumer before it has read every slot poisons the ring, and
+/// the producer stops waiting for slots to be released.
+pub struct BroadcastConsumer<'a, T> {
+    ring: &'a BroadcastRing<T>,
+
+    /// Number of slots read by this consumer
+    pos: usize,
+
+    /// Set after the last slot has been read
+    done: bool,
+}
+impl <'a, T> BroadcastConsumer<'a, T> {
+    /// Wait for the next published slot, read it with 'f', and release it.
+    /// Returns [None] when the producer is finished and all slots have been
+    /// read.
+    pub fn read<R>(&mut self, f: impl FnOnce(&T) -> R) -> Option<R> {
+        let ring = self.ring;
+        let mut spins = 0;
+        while ring.tail.load(Ordering::Acquire) == self.pos {
+            if ring.closed.load(Ordering::Acquire) {
+                if ring.tail.load(Ordering::Acquire) == self.pos {
+                    self.done = true;
+                    return None;
+                }
+                break;
+            }
+            backoff(&mut spins);
+        }
+        let idx = self.pos % ring.capacity();
+        let slot = unsafe { &*ring.slots[idx].get() };
+        let res = f(slot);
+        ring.refs[idx].fetch_sub(1, Ordering::Release);
+        self.pos += 1;
+        Some(res)
+    }
+}
+impl <'a, T> Drop for BroadcastConsumer<'a, T> {
+    fn drop(&mut self) {
+        if !self.done {
+            self.ring.poisoned.store(true, Ordering::Release);
+        }
+    }
+}
+
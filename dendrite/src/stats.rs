@@ -1,11 +1,51 @@
 //! Helpers for collecting statistics.
 
+pub mod window;
+pub mod entropy;
+pub mod export;
+pub mod confidence;
+pub mod perf;
+pub mod phase;
+
+pub use window::*;
+pub use entropy::*;
+pub use export::*;
+pub use confidence::*;
+pub use perf::*;
+pub use phase::*;
+
 use std::collections::*;
 use crate::branch::*;
+use crate::codec::*;
+use crate::heap::*;
+use crate::predictor::Confidence;
 use bitvec::prelude::*;
 use itertools::*;
 
+/// Statistics that can be combined with results collected elsewhere
+/// (ie. from another thread, another chunk of a trace, or another process).
+///
+/// Merging is associative: reducing a set of results in any grouping 
+/// yields the same result, as long as the order of the inputs is preserved.
+pub trait Merge {
+    /// Fold the contents of 'other' into this object.
+    fn merge(&mut self, other: &Self);
+
+    /// Reduce a list of results into a single object.
+    fn merge_all<'a>(iter: impl IntoIterator<Item = &'a Self>) -> Option<Self>
+        where Self: Clone + 'a
+    {
+        let mut iter = iter.into_iter();
+        let mut res = iter.next()?.clone();
+        for x in iter {
+            res.merge(x);
+        }
+        Some(res)
+    }
+}
+
 /// Container for recording simple statistics while evaluating some model.
+#[derive(Clone, Debug, PartialEq)]
 pub struct BranchStats {
     /// Per-branch statistics (indexed by program counter value).
     pub data: BTreeMap<usize, BranchData>,
@@ -15,6 +55,9 @@ pub struct BranchStats {
 
     /// Number of times any branch instruction was executed
     pub global_brns: usize,
+
+    /// Number of correct/incorrect predictions bucketed by confidence
+    pub conf: ConfidenceHistogram,
 }
 impl BranchStats {
     pub fn new() -> Self {
@@ -22,6 +65,7 @@ impl BranchStats {
             data: BTreeMap::new(),
             global_hits: 0,
             global_brns: 0,
+            conf: ConfidenceHistogram::new(),
         }
     }
 
@@ -46,6 +90,13 @@ impl BranchStats {
         if hit { self.global_hits += 1; }
     }
 
+    /// Record the confidence associated with a prediction.
+    pub fn update_confidence(&mut self, record: &BranchRecord, 
+        outcome: Outcome, conf: Confidence) 
+    {
+        self.conf.record(conf, outcome == record.outcome);
+    }
+
     /// Update per-branch statistics.
     pub fn update_per_branch(&mut self,
         record: &BranchRecord, outcome: Outcome)
@@ -53,7 +104,7 @@ impl BranchStats {
         let hit = outcome == record.outcome;
         let data = self.get_mut(record.pc);
         data.occ += 1;
-        data.pat.push(outcome.into());
+        data.pat.push(record.outcome.into());
         if hit { data.hits += 1; }
     }
 
@@ -125,7 +176,21 @@ impl BranchStats {
 
 }
 
+impl HeapSize for BranchStats {
+    fn heap_bytes(&self) -> usize { self.data.heap_bytes() }
+
+    /// Separate the per-branch map from the recorded outcome patterns.
+    fn heap_usage(&self, name: &str) -> HeapUsage {
+        let pats: usize = self.data.values().map(|d| d.pat.heap_bytes()).sum();
+        HeapUsage::from_children(name, vec![
+            HeapUsage::new("branch map", self.data.heap_bytes() - pats),
+            HeapUsage::new("outcome patterns", pats),
+        ])
+    }
+}
+
 /// Container for per-branch statistics.
+#[derive(Clone, Debug, PartialEq)]
 pub struct BranchData {
     /// Number of times this branch was encountered.
     pub occ: usize,
@@ -165,6 +230,7 @@ impl BranchData {
 
     // NOTE: Remember that this isn't too useful apart from telling you
     // whether some sequence of outcomes is mixed or uniform.
+    // See [ConditionalEntropy] for an estimate that accounts for history.
     pub fn shannon_entropy(&self) -> f64 {
         let n   = self.pat.len() as f64;
         let n_t = self.pat.count_ones();
@@ -177,5 +243,75 @@ impl BranchData {
         if res.is_nan() { 0.0 } else { res }
     }
 }
+impl HeapSize for BranchData {
+    fn heap_bytes(&self) -> usize { self.pat.heap_bytes() }
+}
 
+impl Merge for BranchStats {
+    fn merge(&mut self, other: &Self) {
+        self.global_hits += other.global_hits;
+        self.global_brns += other.global_brns;
+        self.conf.merge(&other.conf);
+        for (pc, data) in other.data.iter() {
+            self.get_mut(*pc).merge(data);
+        }
+    }
+}
+
+impl Merge for BranchData {
+    /// NOTE: Outcomes from 'other' are assumed to occur *after* the 
+    /// outcomes recorded in this object. 
+    fn merge(&mut self, other: &Self) {
+        self.occ += other.occ;
+        self.hits += other.hits;
+        self.pat.extend_from_bitslice(other.pat.as_bitslice());
+    }
+}
+
+impl Codec for BranchStats {
+    // Entries are sorted by program counter value, so we only need to 
+    // write the difference between consecutive values. 
+    fn encode(&self, e: &mut Encoder) {
+        e.put_usize(self.global_hits);
+        e.put_usize(self.global_brns);
+        self.conf.encode(e);
+        e.put_usize(self.data.len());
+        let mut prev_pc = 0;
+        for (pc, data) in self.data.iter() {
+            e.put_usize(pc - prev_pc);
+            data.encode(e);
+            prev_pc = *pc;
+        }
+    }
+
+    fn decode(d: &mut Decoder) -> Option<Self> {
+        let mut res = Self::new();
+        res.global_hits = d.get_usize()?;
+        res.global_brns = d.get_usize()?;
+        res.conf = ConfidenceHistogram::decode(d)?;
+        let len = d.get_usize()?;
+        let mut pc = 0usize;
+        for _ in 0..len {
+            pc = pc.checked_add(d.get_usize()?)?;
+            res.data.insert(pc, BranchData::decode(d)?);
+        }
+        Some(res)
+    }
+}
+
+impl Codec for BranchData {
+    fn encode(&self, e: &mut Encoder) {
+        e.put_usize(self.occ);
+        e.put_usize(self.hits);
+        e.put_bits(&self.pat);
+    }
+
+    fn decode(d: &mut Decoder) -> Option<Self> {
+        Some(Self {
+            occ: d.get_usize()?,
+            hits: d.get_usize()?,
+            pat: d.get_bits()?,
+        })
+    }
+}
 
@@ -0,0 +1,105 @@
+
+use crate::codec::*;
+use crate::predictor::Confidence;
+use crate::stats::Merge;
+
+/// Counts of correct and incorrect predictions, bucketed by [Confidence].
+#[derive(Clone, Debug, PartialEq, Eq)]
+pub struct ConfidenceHistogram {
+    /// Number of correct predictions in each bucket
+    pub hits: [usize; Self::NUM_BUCKETS],
+
+    /// Number of incorrect predictions in each bucket
+    pub miss: [usize; Self::NUM_BUCKETS],
+}
+impl ConfidenceHistogram {
+    pub const NUM_BUCKETS: usize = 8;
+
+    pub fn new() -> Self {
+        Self {
+            hits: [0; Self::NUM_BUCKETS],
+            miss: [0; Self::NUM_BUCKETS],
+        }
+    }
+
+    /// Return the bucket for some confidence value.
+    pub fn bucket(conf: Confidence) -> usize {
+        (conf.0 as usize * Self::NUM_BUCKETS) / (Confidence::MAX as usize + 1)
+    }
+
+    /// Return the range of confidence values [between 0.0 and 1.0]
+    /// covered by some bucket.
+    pub fn bucket_range(idx: usize) -> (f64, f64) {
+        let width = 1.0 / Self::NUM_BUCKETS as f64;
+        (idx as f64 * width, (idx + 1) as f64 * width)
+    }
+
+    /// Record the result of a prediction.
+    pub fn record(&mut self, conf: Confidence, hit: bool) {
+        let idx = Self::bucket(conf);
+        if hit {
+            self.hits[idx] += 1;
+        } else {
+            self.miss[idx] += 1;
+        }
+    }
+
+    /// Return the number of predictions in some bucket.
+    pub fn count(&self, idx: usize) -> usize {
+        self.hits[idx] + self.miss[idx]
+    }
+
+    /// Return the total number of recorded predictions.
+    pub fn total(&self) -> usize {
+        (0..Self::NUM_BUCKETS).map(|idx| self.count(idx)).sum()
+    }
+
+    /// Return the hit rate for predictions in some bucket.
+    pub fn hit_rate(&self, idx: usize) -> f64 {
+        self.hits[idx] as f64 / self.count(idx) as f64
+    }
+}
+
+// NOTE: This prints one line for each non-empty bucket. 
+impl std::fmt::Display for ConfidenceHistogram {
+    fn fmt(&self, f: &mut std::fmt::Formatter) -> std::fmt::Result {
+        for idx in 0..Self::NUM_BUCKETS {
+            if self.count(idx) == 0 {
+                continue;
+            }
+            let (lo, hi) = Self::bucket_range(idx);
+            writeln!(f, "[{:.3}, {:.3}): {:10} predictions, {:.2}% correct",
+                lo, hi, self.count(idx), self.hit_rate(idx) * 100.0
+            )?;
+        }
+        Ok(())
+    }
+}
+
+impl Merge for ConfidenceHistogram {
+    fn merge(&mut self, other: &Self) {
+        for idx in 0..Self::NUM_BUCKETS {
+            self.hits[idx] += other.hits[idx];
+            self.miss[idx] += other.miss[idx];
+        }
+    }
+}
+
+impl Codec for ConfidenceHistogram {
+    fn encode(&self, e: &mut Encoder) {
+        for idx in 0..Self::NUM_BUCKETS {
+            e.put_usize(self.hits[idx]);
+            e.put_usize(self.miss[idx]);
+        }
+    }
+
+    fn decode(d: &mut Decoder) -> Option<Self> {
+        let mut res = Self::new();
+        for idx in 0..Self::NUM_BUCKETS {
+            res.hits[idx] = d.get_usize()?;
+            res.miss[idx] = d.get_usize()?;
+        }
+        Some(res)
+    }
+}
+
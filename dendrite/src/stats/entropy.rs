@@ -0,0 +1,214 @@
+
+use std::collections::*;
+use itertools::*;
+use crate::branch::*;
+use crate::hugepage::*;
+
+/// Configuration for a [ConditionalEntropy] analyzer.
+#[derive(Clone, Debug)]
+pub struct EntropyConfig {
+    /// History lengths (in bits) used as context, each at most 64
+    pub lengths: Vec<usize>,
+
+    /// Number of entries in each count table (log2)
+    pub table_bits: usize,
+
+    /// Number of entries in the local history table (log2)
+    pub local_bits: usize,
+}
+impl EntropyConfig {
+    pub fn build(self) -> ConditionalEntropy {
+        ConditionalEntropy::new(self)
+    }
+}
+
+/// A table of taken/not-taken counts indexed by a hash of some context.
+#[derive(Clone, Debug)]
+struct CountTable {
+    data: Vec<[u16; 2]>,
+    bits: usize,
+}
+impl CountTable {
+    fn new(bits: usize) -> Self {
+        Self { data: huge_vec(1 << bits, [0; 2]), bits }
+    }
+
+    /// Hash a program counter value and 'len' bits of history into an index.
+    fn index(&self, pc: usize, hist: u64, len: usize) -> usize {
+        let h = (pc as u64).wrapping_mul(0x9e37_79b9_7f4a_7c15)
+            ^ hist.wrapping_mul(0xc2b2_ae3d_27d4_eb4f)
+            ^ (len as u64).wrapping_mul(0x1656_67b1_9e37_79f9);
+        let h = h ^ (h >> 29);
+        (h.wrapping_mul(0xbf58_476d_1ce4_e5b9) >> (64 - self.bits)) as usize
+    }
+
+    /// Return the cost (in bits) of coding an outcome with the counts in
+    /// some entry, then update the entry.
+    ///
+    /// This uses the Krichevsky–Trofimov estimator: both outcomes start
+    /// with a count of 1/2. Counts are halved when they saturate, so the
+    /// estimate is able to track slow changes in behavior.
+    fn code(&mut self, idx: usize, outcome: Outcome) -> f64 {
+        let entry = &mut self.data[idx];
+        let o = outcome as usize;
+        let n = entry[0] as f64 + entry[1] as f64 + 1.0;
+        let p = (entry[o] as f64 + 0.5) / n;
+        if entry[o] == u16::MAX {
+            entry[0] >>= 1;
+            entry[1] >>= 1;
+        }
+        entry[o] += 1;
+        -p.log2()
+    }
+}
+
+/// Container for per-branch results from a [ConditionalEntropy] analyzer.
+#[derive(Clone, Debug)]
+pub struct EntropyData {
+    /// Number of times this branch was encountered
+    pub occ: usize,
+
+    /// Number of times this branch was taken
+    pub taken: usize,
+
+    /// Total coding cost (in bits) given each length of global history
+    pub global_bits: Vec<f64>,
+
+    /// Total coding cost (in bits) given each length of local history
+    pub local_bits: Vec<f64>,
+}
+impl EntropyData {
+    fn new(num_lengths: usize) -> Self {
+        Self {
+            occ: 0,
+            taken: 0,
+            global_bits: vec![0.0; num_lengths],
+            local_bits: vec![0.0; num_lengths],
+        }
+    }
+
+    /// Return the entropy of the taken/not-taken bias for this branch.
+    pub fn bias_entropy(&self) -> f64 {
+        let p_t = self.taken as f64 / self.occ as f64;
+        let p_f = 1.0 - p_t;
+        let res = -(p_t * p_t.log2() + p_f * p_f.log2());
+        if res.is_nan() { 0.0 } else { res }
+    }
+
+    /// Return the estimated entropy (in bits per outcome) given the
+    /// global history length at index 'idx' in the configuration.
+    pub fn global_entropy(&self, idx: usize) -> f64 {
+        self.global_bits[idx] / self.occ as f64
+    }
+
+    /// Return the estimated entropy (in bits per outcome) given the
+    /// local history length at index 'idx' in the configuration.
+    pub fn local_entropy(&self, idx: usize) -> f64 {
+        self.local_bits[idx] / self.occ as f64
+    }
+}
+
+/// Streaming estimator for the conditional entropy of each branch outcome,
+/// given the last 'k' global and local outcomes (for several values of 'k').
+///
+/// For each history length, a fixed-size table of counts is indexed with a
+/// hash of the program counter and history. Each outcome is "coded" with
+/// the adaptive probability from the table before the table is updated, and
+/// the average cost per outcome converges on the conditional entropy.
+///
+/// This tells you how much information about the next outcome is present
+/// in some amount of history, without simulating any particular predictor.
+/// A branch whose entropy stays high for all lengths is likely to be
+/// inherently unpredictable; a branch whose entropy only drops for longer
+/// histories needs more history.
+///
+/// NOTE: Unrelated contexts may alias in the count tables, and the cost of
+/// learning is included in the estimate. Both of these make the result an
+/// *upper bound*, and short-running branches will appear more random than
+/// they actually are.
+pub struct ConditionalEntropy {
+    cfg: EntropyConfig,
+
+    /// Global history of conditional branch outcomes
+    ghist: u64,
+
+    /// Local histories (indexed by a hash of the program counter)
+    lhist: Vec<u64>,
+
+    /// Count tables for global history (one for each length)
+    global: Vec<CountTable>,
+
+    /// Count tables for local history (one for each length)
+    local: Vec<CountTable>,
+
+    /// Per-branch results (indexed by program counter value)
+    pub data: HashMap<usize, EntropyData>,
+}
+impl ConditionalEntropy {
+    pub fn new(cfg: EntropyConfig) -> Self {
+        assert!(cfg.lengths.iter().all(|len| *len <= 64));
+        let global = cfg.lengths.iter()
+            .map(|_| CountTable::new(cfg.table_bits)).collect();
+        let local = cfg.lengths.iter()
+            .map(|_| CountTable::new(cfg.table_bits)).collect();
+        Self {
+            lhist: vec![0; 1 << cfg.local_bits],
+            ghist: 0,
+            global,
+            local,
+            data: HashMap::new(),
+            cfg,
+        }
+    }
+
+    /// Return the list of history lengths.
+    pub fn lengths(&self) -> &[usize] { &self.cfg.lengths }
+
+    fn history_mask(len: usize) -> u64 {
+        if len >= 64 { u64::MAX } else { (1 << len) - 1 }
+    }
+
+    /// Record the outcome of a conditional branch.
+    pub fn update(&mut self, record: &BranchRecord) {
+        if !record.is_conditional() {
+            return;
+        }
+        let pc = record.pc;
+        let outcome = record.outcome;
+        let lidx = (pc ^ (pc >> self.cfg.local_bits))
+            & ((1 << self.cfg.local_bits) - 1);
+        let lhist = self.lhist[lidx];
+
+        let num_lengths = self.cfg.lengths.len();
+        let data = self.data.entry(pc)
+            .or_insert_with(|| EntropyData::new(num_lengths));
+        data.occ += 1;
+        if outcome == Outcome::T { data.taken += 1; }
+
+        for (idx, len) in self.cfg.lengths.iter().enumerate() {
+            let mask = Self::history_mask(*len);
+
+            let table = &mut self.global[idx];
+            let i = table.index(pc, self.ghist & mask, *len);
+            data.global_bits[idx] += table.code(i, outcome);
+
+            let table = &mut self.local[idx];
+            let i = table.index(pc, lhist & mask, *len);
+            data.local_bits[idx] += table.code(i, outcome);
+        }
+
+        let bit = outcome as u64;
+        self.ghist = (self.ghist << 1) | bit;
+        self.lhist[lidx] = (lhist << 1) | bit;
+    }
+
+    /// Return the 'n' most frequently executed branches.
+    pub fn get_hot_branches(&self, n: usize) -> Vec<(usize, &EntropyData)> {
+        self.data.iter()
+            .sorted_by(|x, y| y.1.occ.cmp(&x.1.occ).then(x.0.cmp(y.0)))
+            .take(n)
+            .map(|(pc, d)| (*pc, d))
+            .collect()
+    }
+}
+
@@ -0,0 +1,275 @@
+
+use std::fs::{ File, OpenOptions };
+use std::io::{ BufReader, BufWriter, Read, Write };
+use crate::codec::*;
+use crate::stats::*;
+
+/// A column of values in a [ResultTable].
+#[derive(Clone, Debug, PartialEq)]
+pub enum Column {
+    U64(Vec<u64>),
+    F64(Vec<f64>),
+}
+impl Column {
+    const TYPE_U64: u8 = 0;
+    const TYPE_F64: u8 = 1;
+
+    pub fn len(&self) -> usize {
+        match self {
+            Self::U64(v) => v.len(),
+            Self::F64(v) => v.len(),
+        }
+    }
+
+    pub fn as_u64(&self) -> Option<&[u64]> {
+        if let Self::U64(v) = self { Some(v) } else { None }
+    }
+
+    pub fn as_f64(&self) -> Option<&[f64]> {
+        if let Self::F64(v) = self { Some(v) } else { None }
+    }
+}
+
+/// Per-branch and global results from a single run, stored by column.
+///
+/// Each row in the table corresponds to a single branch. Global results are
+/// stored as a list of named counts.
+#[derive(Clone, Debug, PartialEq)]
+pub struct ResultTable {
+    /// Name identifying this run
+    pub name: String,
+
+    /// Global counts
+    pub globals: Vec<(String, u64)>,
+
+    /// Per-branch columns
+    pub columns: Vec<(String, Column)>,
+}
+impl ResultTable {
+    pub fn new(name: impl ToString) -> Self {
+        Self {
+            name: name.to_string(),
+            globals: Vec::new(),
+            columns: Vec::new(),
+        }
+    }
+
+    /// Create a table with the program counter, number of occurences,
+    /// number of hits, and [bias] entropy for each branch in some
+    /// [BranchStats].
+    pub fn from_branch_stats(name: impl ToString, stats: &BranchStats)
+        -> Self
+    {
+        let mut res = Self::new(name);
+        res.add_global("hits", stats.global_hits() as u64);
+        res.add_global("brns", stats.global_brns() as u64);
+        res.add_column("pc", Column::U64(
+            stats.data.keys().map(|pc| *pc as u64).collect()
+        ));
+        res.add_column("occ", Column::U64(
+            stats.data.values().map(|d| d.occ as u64).collect()
+        ));
+        res.add_column("hits", Column::U64(
+            stats.data.values().map(|d| d.hits as u64).collect()
+        ));
+        res.add_column("entropy", Column::F64(
+            stats.data.values().map(|d| d.shannon_entropy()).collect()
+        ));
+        res
+    }
+
+    /// Return the number of rows in the table.
+    pub fn num_rows(&self) -> usize {
+        self.columns.first().map(|(_, c)| c.len()).unwrap_or(0)
+    }
+
+    pub fn add_global(&mut self, name: &str, val: u64) {
+        self.globals.push((name.to_string(), val));
+    }
+
+    /// Add a column to the table.
+    /// All columns must have the same number of rows.
+    pub fn add_column(&mut self, name: &str, col: Column) {
+        if !self.columns.is_empty() {
+            assert!(col.len() == self.num_rows());
+        }
+        self.columns.push((name.to_string(), col));
+    }
+
+    pub fn global(&self, name: &str) -> Option<u64> {
+        self.globals.iter().find(|(n, _)| n == name).map(|(_, v)| *v)
+    }
+
+    pub fn column(&self, name: &str) -> Option<&Column> {
+        self.columns.iter().find(|(n, _)| n == name).map(|(_, c)| c)
+    }
+
+    fn encode(&self, e: &mut Encoder) {
+        e.put_str(&self.name);
+        e.put_usize(self.globals.len());
+        for (name, val) in self.globals.iter() {
+            e.put_str(name);
+            e.put_u64(*val);
+        }
+        e.put_usize(self.num_rows());
+        e.put_usize(self.columns.len());
+        for (name, col) in self.columns.iter() {
+            e.put_str(name);
+            match col {
+                Column::U64(v) => {
+                    e.put_u8(Column::TYPE_U64);
+                    v.iter().for_each(|x| e.put_u64(*x));
+                },
+                Column::F64(v) => {
+                    e.put_u8(Column::TYPE_F64);
+                    v.iter().for_each(|x| e.put_f64(*x));
+                },
+            }
+        }
+    }
+
+    fn decode(d: &mut Decoder) -> Option<Self> {
+        let mut res = Self::new(d.get_str()?);
+        let num_globals = d.get_usize()?;
+        for _ in 0..num_globals {
+            let name = d.get_str()?;
+            res.globals.push((name, d.get_u64()?));
+        }
+        let num_rows = d.get_usize()?;
+        let num_cols = d.get_usize()?;
+        for _ in 0..num_cols {
+            let name = d.get_str()?;
+            let kind = d.get_u8()?;
+            let raw = d.get_raw(num_rows.checked_mul(8)?)?;
+            let words = raw.chunks_exact(8)
+                .map(|b| u64::from_le_bytes(b.try_into().unwrap()));
+            let col = match kind {
+                Column::TYPE_U64 => Column::U64(words.collect()),
+                Column::TYPE_F64 => Column::F64(words.map(f64::from_bits)
+                    .collect()),
+                _ => return None,
+            };
+            res.columns.push((name, col));
+        }
+        Some(res)
+    }
+}
+
+/// Appends [ResultTable]s to a file.
+///
+/// Each table is written as a single self-delimiting block (magic bytes,
+/// the length of the block, then the encoded table), so results from many
+/// runs can be appended to the same file. Columns are stored as contiguous
+/// arrays of 64-bit little-endian values.
+pub struct ResultWriter {
+    out: BufWriter<File>,
+}
+impl ResultWriter {
+    pub const MAGIC: &'static [u8] = b"DRES";
+
+    /// Open a file for appending [creating it if necessary].
+    pub fn append(path: &str) -> std::io::Result<Self> {
+        let f = OpenOptions::new().create(true).append(true).open(path)?;
+        Ok(Self { out: BufWriter::new(f) })
+    }
+
+    pub fn write(&mut self, table: &ResultTable) -> std::io::Result<()> {
+        let mut e = Encoder::new();
+        table.encode(&mut e);
+        self.out.write_all(Self::MAGIC)?;
+        self.out.write_all(&(e.len() as u64).to_le_bytes())?;
+        self.out.write_all(e.as_bytes())?;
+        self.out.flush()
+    }
+}
+
+/// Reads [ResultTable]s from a file written by [ResultWriter].
+pub struct ResultReader {
+    inp: BufReader<File>,
+    buf: Vec<u8>,
+
+    /// Length of the file
+    len: u64,
+
+    /// Number of bytes in all complete blocks read so far
+    pos: u64,
+}
+impl ResultReader {
+    pub fn open(path: &str) -> std::io::Result<Self> {
+        let f = File::open(path)?;
+        let len = f.metadata()?.len();
+        Ok(Self {
+            inp: BufReader::new(f),
+            buf: Vec::new(),
+            len,
+            pos: 0,
+        })
+    }
+
+    /// Return the offset in the file after the last complete block. 
+    /// If reading fails (ie. because the last block was only partially 
+    /// written), this is the length of the valid part of the file.
+    pub fn valid_len(&self) -> u64 { self.pos }
+
+    /// Read all tables from a file.
+    pub fn read_all(path: &str) -> std::io::Result<Vec<ResultTable>> {
+        Self::open(path)?.collect()
+    }
+
+    /// Read the next block from the file into the internal buffer.
+    /// Returns 'false' at the end of the file.
+    ///
+    /// A header that is only partially present, or a block which is longer
+    /// than the rest of the file, is an error [ie. the last block was only 
+    /// partially written]. 
+    fn next_block(&mut self) -> std::io::Result<bool> {
+        let mut hdr = [0u8; 12];
+        let mut filled = 0;
+        while filled < hdr.len() {
+            match self.inp.read(&mut hdr[filled..]) {
+                Ok(0) => break,
+                Ok(n) => filled += n,
+                Err(e) if e.kind() == std::io::ErrorKind::Interrupted => {},
+                Err(e) => return Err(e),
+            }
+        }
+        if filled == 0 {
+            return Ok(false);
+        }
+        if filled < hdr.len() {
+            return Err(std::io::Error::new(std::io::ErrorKind::UnexpectedEof,
+                "truncated result table header"));
+        }
+        if &hdr[0..4] != ResultWriter::MAGIC {
+            return Err(Self::invalid_data());
+        }
+        let len = u64::from_le_bytes(hdr[4..12].try_into().unwrap());
+        let remaining = self.len.saturating_sub(self.pos + hdr.len() as u64);
+        if len > remaining {
+            return Err(std::io::Error::new(std::io::ErrorKind::UnexpectedEof,
+                "truncated result table"));
+        }
+        self.buf.resize(len as usize, 0);
+        self.inp.read_exact(&mut self.buf)?;
+        self.pos += hdr.len() as u64 + len;
+        Ok(true)
+    }
+
+    fn invalid_data() -> std::io::Error {
+        std::io::Error::new(std::io::ErrorKind::InvalidData,
+            "malformed result table")
+    }
+}
+impl Iterator for ResultReader {
+    type Item = std::io::Result<ResultTable>;
+    fn next(&mut self) -> Option<Self::Item> {
+        match self.next_block() {
+            Ok(true) => {},
+            Ok(false) => return None,
+            Err(e) => return Some(Err(e)),
+        }
+        let mut d = Decoder::new(&self.buf);
+        Some(ResultTable::decode(&mut d).ok_or(Self::invalid_data()))
+    }
+}
+
@@ -0,0 +1,117 @@
+
+use std::time::{ Duration, Instant };
+
+/// Phases of a run reported by a [PerfSummary]. 
+#[derive(Clone, Copy, Debug, PartialEq, Eq)]
+pub enum Phase {
+    /// Reading the trace
+    Load,
+
+    /// Warming up predictor state before measurement
+    Warmup,
+
+    /// Evaluating the trace
+    Eval,
+}
+impl Phase {
+    const ALL: [Self; 3] = [Self::Load, Self::Warmup, Self::Eval];
+
+    pub fn name(&self) -> &'static str {
+        match self {
+            Self::Load => "load",
+            Self::Warmup => "warmup",
+            Self::Eval => "eval",
+        }
+    }
+}
+
+/// Collects time spent in each [Phase] of a run, along with throughput and
+/// memory usage. 
+///
+/// [PerfSummary::summary] produces a single line of 'key=value' pairs, so
+/// results from different versions and machines can be compared with 
+/// simple tools. All phases are always present [with zero when unused].
+#[derive(Clone, Debug)]
+pub struct PerfSummary {
+    /// Name of the tool being measured
+    pub name: String,
+
+    /// Total time spent in each phase
+    times: [Duration; 3],
+
+    /// Number of records evaluated
+    pub num_records: usize,
+
+    /// Number of conditional branches evaluated
+    pub num_conditional: usize,
+}
+impl PerfSummary {
+    pub fn new(name: impl ToString) -> Self {
+        Self {
+            name: name.to_string(),
+            times: [Duration::ZERO; 3],
+            num_records: 0,
+            num_conditional: 0,
+        }
+    }
+
+    /// Run 'f' and add the elapsed time to some phase.
+    pub fn time<R>(&mut self, phase: Phase, f: impl FnOnce() -> R) -> R {
+        let start = Instant::now();
+        let res = f();
+        self.add(phase, start.elapsed());
+        res
+    }
+
+    /// Add some amount of time to a phase.
+    pub fn add(&mut self, phase: Phase, time: Duration) {
+        self.times[phase as usize] += time;
+    }
+
+    pub fn get(&self, phase: Phase) -> Duration {
+        self.times[phase as usize]
+    }
+
+    /// Record the number of records and conditional branches evaluated.
+    pub fn set_counts(&mut self, num_records: usize, num_conditional: usize) {
+        self.num_records = num_records;
+        self.num_conditional = num_conditional;
+    }
+
+    /// Number of records evaluated per second [during evaluation].
+    pub fn records_per_sec(&self) -> f64 {
+        self.num_records as f64 / self.get(Phase::Eval).as_secs_f64()
+    }
+
+    /// Number of conditional branches evaluated per second 
+    /// [during evaluation].
+    pub fn conditional_per_sec(&self) -> f64 {
+        self.num_conditional as f64 / self.get(Phase::Eval).as_secs_f64()
+    }
+
+    /// Return the peak resident set size of this process [in KiB].
+    /// Only available on Linux.
+    pub fn peak_rss_kib() -> Option<usize> {
+        let status = std::fs::read_to_string("/proc/self/status").ok()?;
+        let line = status.lines().find(|l| l.starts_with("VmHWM:"))?;
+        line.split_whitespace().nth(1)?.parse().ok()
+    }
+
+    /// Return a single-line summary of the run.
+    pub fn summary(&self) -> String {
+        let mut res = format!("[perf] tool={}", self.name);
+        for phase in Phase::ALL {
+            res += &format!(" {}_s={:.6}", phase.name(), 
+                self.get(phase).as_secs_f64());
+        }
+        res += &format!(" records={} conditional={} records_per_s={:.0} \
+            conditional_per_s={:.0}", self.num_records, self.num_conditional,
+            self.records_per_sec(), self.conditional_per_sec());
+        match Self::peak_rss_kib() {
+            Some(kib) => res += &format!(" peak_rss_kib={}", kib),
+            None => res += " peak_rss_kib=NA",
+        }
+        res
+    }
+}
+
@@ -0,0 +1,422 @@
+
+use std::collections::*;
+use std::fs::File;
+use std::io::{ BufRead, BufReader, BufWriter, Write };
+use std::ops::Range;
+use crate::branch::*;
+use crate::pool::*;
+use crate::predictor::XorShift64;
+
+/// Per-interval branch frequency vectors, randomly projected down to a small
+/// number of dimensions.
+///
+/// This is the "basic block vector" used by SimPoint (see "Automatically
+/// Characterizing Large Scale Program Behavior", Sherwood et al., 2002),
+/// except that each branch program counter (rather than each basic block)
+/// is a dimension. Each vector is normalized by the length of the interval
+/// before being projected.
+#[derive(Clone, Debug)]
+pub struct IntervalVectors {
+    /// Number of records in each interval
+    pub interval_len: usize,
+
+    /// Number of records in the trace
+    pub num_records: usize,
+
+    /// Number of dimensions in each vector
+    pub dims: usize,
+
+    /// One projected vector for each interval
+    pub data: Vec<Vec<f64>>,
+}
+impl IntervalVectors {
+    /// Split a trace into intervals of 'interval_len' records and build the
+    /// projected vector for each interval.
+    ///
+    /// A trailing interval shorter than half of 'interval_len' is ignored.
+    pub fn build(records: &[BranchRecord], interval_len: usize, dims: usize,
+        seed: u64, pool: &WorkPool) -> Self
+    {
+        assert!(interval_len != 0 && dims != 0);
+        let mut num_intervals = records.len() / interval_len;
+        if records.len() % interval_len >= interval_len / 2 {
+            num_intervals += 1;
+        }
+
+        // Each job is a contiguous block of intervals
+        let num_jobs = (pool.num_threads() * 4).min(num_intervals).max(1);
+        let jobs: Vec<Range<usize>> = (0..num_jobs).map(|idx| {
+            idx * num_intervals / num_jobs..(idx + 1) * num_intervals / num_jobs
+        }).collect();
+        let blocks = pool.map(jobs, |_, range| {
+            let mut counts = HashMap::new();
+            range.map(|idx| {
+                let start = idx * interval_len;
+                let end = (start + interval_len).min(records.len());
+                counts.clear();
+                for record in &records[start..end] {
+                    *counts.entry(record.pc).or_insert(0usize) += 1;
+                }
+                Self::project(&counts, end - start, dims, seed)
+            }).collect::<Vec<_>>()
+        });
+
+        Self {
+            interval_len,
+            num_records: records.len(),
+            dims,
+            data: blocks.into_iter().flatten().collect(),
+        }
+    }
+
+    /// Project a map of counts onto 'dims' dimensions. Each program counter
+    /// value is mapped to a fixed random vector with elements uniformly
+    /// distributed in [-1, 1).
+    fn project(counts: &HashMap<usize, usize>, len: usize, dims: usize,
+        seed: u64) -> Vec<f64>
+    {
+        let mut res = vec![0.0; dims];
+        for (pc, cnt) in counts.iter() {
+            let freq = *cnt as f64 / len as f64;
+            let mut rng = XorShift64::new(
+                (*pc as u64).wrapping_mul(0x9e37_79b9_7f4a_7c15) ^ seed
+            );
+            for x in res.iter_mut() {
+                let r = (rng.next_u64() >> 11) as f64 / (1u64 << 53) as f64;
+                *x += freq * (r * 2.0 - 1.0);
+            }
+        }
+        res
+    }
+
+    pub fn len(&self) -> usize { self.data.len() }
+
+    /// Return the range of records covered by some interval.
+    pub fn interval(&self, idx: usize, num_records: usize) -> Range<usize> {
+        let start = idx * self.interval_len;
+        start..(start + self.interval_len).min(num_records)
+    }
+}
+
+fn dist2(a: &[f64], b: &[f64]) -> f64 {
+    a.iter().zip(b).map(|(x, y)| (x - y) * (x - y)).sum()
+}
+
+/// The result of clustering some vectors with [KMeans].
+#[derive(Clone, Debug)]
+pub struct Clustering {
+    /// The cluster assigned to each vector
+    pub assignment: Vec<usize>,
+
+    /// The center of each cluster
+    pub centroids: Vec<Vec<f64>>,
+
+    /// Sum of squared distances from each vector to its centroid
+    pub sse: f64,
+
+    /// Bayesian information criterion for this clustering [larger is better]
+    pub bic: f64,
+}
+impl Clustering {
+    pub fn k(&self) -> usize { self.centroids.len() }
+
+    /// Return the number of vectors in each cluster.
+    pub fn sizes(&self) -> Vec<usize> {
+        let mut res = vec![0; self.k()];
+        self.assignment.iter().for_each(|c| res[*c] += 1);
+        res
+    }
+
+    /// Compute the BIC score, following the formulation used by SimPoint
+    /// (from "X-means", Pelleg and Moore, 2000).
+    fn compute_bic(&mut self, dims: usize) {
+        let r = self.assignment.len() as f64;
+        let k = self.k() as f64;
+        let m = dims as f64;
+        let var = if r > k { self.sse / (r - k) } else { 0.0 };
+        if var <= 0.0 {
+            self.bic = f64::INFINITY;
+            return;
+        }
+        let mut ll = 0.0;
+        for size in self.sizes().iter().filter(|s| **s != 0) {
+            let ri = *size as f64;
+            ll += ri * ri.ln() - ri * r.ln()
+                - ri * 0.5 * (2.0 * std::f64::consts::PI).ln()
+                - ri * m * 0.5 * var.ln()
+                - (ri - k) * 0.5;
+        }
+        let params = (k - 1.0) + m * k + 1.0;
+        self.bic = ll - params * 0.5 * r.ln();
+    }
+}
+
+/// Parallel k-means clustering [with k-means++ initialization].
+#[derive(Clone, Copy, Debug)]
+pub struct KMeans {
+    /// Maximum number of iterations for each run
+    pub max_iter: usize,
+
+    /// Number of runs with different initial centroids [the run with the
+    /// lowest SSE is kept]
+    pub restarts: usize,
+
+    pub seed: u64,
+}
+impl KMeans {
+    pub fn new(seed: u64) -> Self {
+        Self { max_iter: 100, restarts: 5, seed }
+    }
+
+    /// Cluster some vectors into 'k' clusters.
+    pub fn run(&self, data: &[Vec<f64>], k: usize, pool: &WorkPool)
+        -> Clustering
+    {
+        assert!(k != 0 && k <= data.len());
+        let mut rng = XorShift64::new(self.seed ^ ((k as u64) << 32));
+        let mut best: Option<Clustering> = None;
+        for _ in 0..self.restarts.max(1) {
+            let res = self.run_once(data, k, pool, &mut rng);
+            if best.as_ref().map_or(true, |b| res.sse < b.sse) {
+                best = Some(res);
+            }
+        }
+        let mut res = best.unwrap();
+        res.compute_bic(data[0].len());
+        res
+    }
+
+    /// Cluster with 'k' = 1 to 'max_k', and select the smallest 'k' whose
+    /// BIC score is at least 'threshold' of the way between the lowest and
+    /// highest scores (SimPoint uses 0.9).
+    ///
+    /// Returns [None] if there are no vectors [or 'max_k' is zero].
+    pub fn run_bic(&self, data: &[Vec<f64>], max_k: usize, threshold: f64,
+        pool: &WorkPool) -> Option<Clustering>
+    {
+        let max_k = max_k.min(data.len());
+        let mut runs: Vec<Clustering> = (1..=max_k)
+            .map(|k| self.run(data, k, pool))
+            .collect();
+        if runs.is_empty() {
+            return None;
+        }
+        let scores = runs.iter().map(|c| c.bic).filter(|b| b.is_finite());
+        let lo = scores.clone().fold(f64::MAX, f64::min);
+        let hi = scores.fold(f64::MIN, f64::max);
+        let limit = lo + (hi - lo) * threshold;
+
+        // Fall back to the smallest 'k' if no score is usable
+        let idx = runs.iter().position(|c| c.bic >= limit).unwrap_or(0);
+        Some(runs.swap_remove(idx))
+    }
+
+    fn run_once(&self, data: &[Vec<f64>], k: usize, pool: &WorkPool,
+        rng: &mut XorShift64) -> Clustering
+    {
+        let mut centroids = Self::init(data, k, rng);
+        let mut assignment = vec![usize::MAX; data.len()];
+        let mut sse = 0.0;
+
+        // Each job is a contiguous block of vectors
+        let num_jobs = (pool.num_threads() * 4).min(data.len());
+        let jobs: Vec<Range<usize>> = (0..num_jobs).map(|idx| {
+            idx * data.len() / num_jobs..(idx + 1) * data.len() / num_jobs
+        }).collect();
+
+        for _ in 0..self.max_iter {
+            // Assign each vector to the nearest centroid, and compute the
+            // partial sums for the new centroids in each block
+            let parts = pool.map(jobs.clone(), |_, range| {
+                let dims = data[0].len();
+                let mut sums = vec![vec![0.0; dims]; k];
+                let mut counts = vec![0usize; k];
+                let mut sse = 0.0;
+                let assign: Vec<usize> = range.map(|idx| {
+                    let (c, d) = centroids.iter().enumerate()
+                        .map(|(c, x)| (c, dist2(&data[idx], x)))
+                        .min_by(|a, b| a.1.partial_cmp(&b.1).unwrap())
+                        .unwrap();
+                    sums[c].iter_mut().zip(&data[idx]).for_each(|(s, x)| {
+                        *s += x;
+                    });
+                    counts[c] += 1;
+                    sse += d;
+                    c
+                }).collect();
+                (assign, sums, counts, sse)
+            });
+
+            let mut changed = false;
+            let mut sums = vec![vec![0.0; data[0].len()]; k];
+            let mut counts = vec![0usize; k];
+            sse = 0.0;
+            for (range, (assign, psums, pcounts, psse)) in jobs.iter().zip(parts) {
+                for (idx, c) in range.clone().zip(assign) {
+                    changed |= assignment[idx] != c;
+                    assignment[idx] = c;
+                }
+                for c in 0..k {
+                    sums[c].iter_mut().zip(&psums[c]).for_each(|(s, x)| *s += x);
+                    counts[c] += pcounts[c];
+                }
+                sse += psse;
+            }
+            if !changed {
+                break;
+            }
+
+            // Empty clusters keep their previous centroid
+            for c in 0..k {
+                if counts[c] != 0 {
+                    let n = counts[c] as f64;
+                    centroids[c] = sums[c].iter().map(|s| s / n).collect();
+                }
+            }
+        }
+        Clustering { assignment, centroids, sse, bic: 0.0 }
+    }
+
+    /// Choose initial centroids with k-means++ (Arthur and Vassilvitskii,
+    /// 2007): each centroid is chosen with probability proportional to the
+    /// squared distance from the nearest centroid chosen so far.
+    fn init(data: &[Vec<f64>], k: usize, rng: &mut XorShift64)
+        -> Vec<Vec<f64>>
+    {
+        let first = (rng.next_u64() % data.len() as u64) as usize;
+        let mut res = vec![data[first].clone()];
+        let mut dist: Vec<f64> = data.iter()
+            .map(|x| dist2(x, &res[0]))
+            .collect();
+        while res.len() < k {
+            let total: f64 = dist.iter().sum();
+            let next = if total <= 0.0 {
+                (rng.next_u64() % data.len() as u64) as usize
+            } else {
+                let r = (rng.next_u64() >> 11) as f64 / (1u64 << 53) as f64;
+                let mut x = r * total;
+                dist.iter().position(|d| { x -= d; x < 0.0 })
+                    .unwrap_or(data.len() - 1)
+            };
+            res.push(data[next].clone());
+            for (d, x) in dist.iter_mut().zip(data) {
+                *d = d.min(dist2(x, &data[next]));
+            }
+        }
+        res
+    }
+}
+
+/// A representative interval selected from some cluster.
+#[derive(Clone, Copy, Debug, PartialEq)]
+pub struct SimPoint {
+    /// Index of the interval
+    pub interval: usize,
+
+    /// Fraction of the records [in all intervals] that are in the cluster
+    /// represented by this interval
+    pub weight: f64,
+}
+
+/// A list of representative intervals for some trace.
+///
+/// The file format is plain text: a header line ('#interval_len' and the
+/// interval length, separated by a tab) followed by one line for each
+/// interval with the index and weight.
+#[derive(Clone, Debug, PartialEq)]
+pub struct SimPointList {
+    /// Number of records in each interval
+    pub interval_len: usize,
+
+    /// Representative intervals [sorted by index]
+    pub points: Vec<SimPoint>,
+}
+impl SimPointList {
+    /// Select the interval closest to the centroid of each cluster.
+    pub fn from_clustering(vectors: &IntervalVectors, clustering: &Clustering)
+        -> Self
+    {
+        // Weight each cluster by the number of records in its intervals
+        // [the trailing interval may be shorter than the others]
+        let mut sizes = vec![0; clustering.k()];
+        for (idx, c) in clustering.assignment.iter().enumerate() {
+            sizes[*c] += vectors.interval(idx, vectors.num_records).len();
+        }
+        let total = sizes.iter().sum::<usize>() as f64;
+        let mut points: Vec<SimPoint> = (0..clustering.k())
+            .filter(|c| sizes[*c] != 0)
+            .map(|c| {
+                let interval = (0..vectors.len())
+                    .filter(|idx| clustering.assignment[*idx] == c)
+                    .min_by(|a, b| {
+                        let da = dist2(&vectors.data[*a], &clustering.centroids[c]);
+                        let db = dist2(&vectors.data[*b], &clustering.centroids[c]);
+                        da.partial_cmp(&db).unwrap()
+                    }).unwrap();
+                SimPoint { interval, weight: sizes[c] as f64 / total }
+            }).collect();
+        points.sort_by_key(|p| p.interval);
+        Self { interval_len: vectors.interval_len, points }
+    }
+
+    pub fn write(&self, path: &str) -> std::io::Result<()> {
+        let mut out = BufWriter::new(File::create(path)?);
+        writeln!(out, "#interval_len\t{}", self.interval_len)?;
+        for p in self.points.iter() {
+            writeln!(out, "{}\t{}", p.interval, p.weight)?;
+        }
+        out.flush()
+    }
+
+    /// Read a list written by [SimPointList::write] for a trace with
+    /// 'num_records' records.
+    ///
+    /// Points are sorted by interval. Returns an error if an interval is
+    /// repeated or lies outside of the trace. 
+    pub fn read(path: &str, num_records: usize) -> std::io::Result<Self> {
+        let invalid = || std::io::Error::new(std::io::ErrorKind::InvalidData,
+            "malformed simpoint list");
+        let mut lines = BufReader::new(File::open(path)?).lines();
+        let hdr = lines.next().ok_or_else(invalid)??;
+        let interval_len = hdr.strip_prefix("#interval_len\t")
+            .and_then(|s| s.trim().parse().ok())
+            .ok_or_else(invalid)?;
+        let mut points = Vec::new();
+        for line in lines {
+            let line = line?;
+            let mut fields = line.split('\t');
+            let interval = fields.next().and_then(|s| s.parse().ok());
+            let weight = fields.next().and_then(|s| s.trim().parse().ok());
+            match (interval, weight) {
+                (Some(interval), Some(weight)) => {
+                    points.push(SimPoint { interval, weight });
+                },
+                _ => return Err(invalid()),
+            }
+        }
+        if interval_len == 0 {
+            return Err(invalid());
+        }
+
+        points.sort_by_key(|p| p.interval);
+        let num_intervals = (num_records + interval_len - 1) / interval_len;
+        for (idx, p) in points.iter().enumerate() {
+            let msg = if p.interval >= num_intervals {
+                format!("{}: interval {} is outside of the trace ({} \
+                    intervals of {} records)", path, p.interval, 
+                    num_intervals, interval_len)
+            } else if idx > 0 && points[idx - 1].interval == p.interval {
+                format!("{}: interval {} is repeated", path, p.interval)
+            } else if !(p.weight >= 0.0 && p.weight.is_finite()) {
+                format!("{}: interval {} has an invalid weight", path, 
+                    p.interval)
+            } else {
+                continue;
+            };
+            return Err(std::io::Error::new(std::io::ErrorKind::InvalidData, 
+                msg));
+        }
+        Ok(Self { interval_len, points })
+    }
+}
+
@@ -0,0 +1,303 @@
+
+use std::fs::File;
+use std::io::{ BufWriter, Read, Write };
+use crate::checkpoint::SaveState;
+use crate::codec::*;
+use crate::stats::Merge;
+
+/// A series of misprediction counts, collected over fixed-size windows
+/// of conditional branches.
+///
+/// The last window in the series may be partially filled.
+#[derive(Clone, Debug, PartialEq, Eq)]
+pub struct WindowSeries {
+    /// Number of branches in each window
+    pub window: usize,
+
+    /// Number of branches observed in each window
+    pub brns: Vec<usize>,
+
+    /// Number of mispredictions observed in each window
+    pub miss: Vec<usize>,
+}
+impl WindowSeries {
+    pub fn new(window: usize) -> Self {
+        assert!(window != 0);
+        Self {
+            window,
+            brns: Vec::new(),
+            miss: Vec::new(),
+        }
+    }
+
+    /// Return the number of windows [including a partially-filled window].
+    pub fn len(&self) -> usize { self.brns.len() }
+
+    /// Record the result of a single prediction.
+    pub fn record(&mut self, hit: bool) {
+        match self.brns.last() {
+            Some(n) if *n < self.window => {},
+            _ => {
+                self.brns.push(0);
+                self.miss.push(0);
+            },
+        }
+        let idx = self.brns.len() - 1;
+        self.brns[idx] += 1;
+        if !hit { self.miss[idx] += 1; }
+    }
+
+    /// Append the counts for a complete window.
+    pub fn push(&mut self, brns: usize, miss: usize) {
+        self.brns.push(brns);
+        self.miss.push(miss);
+    }
+
+    /// Return the total number of branches.
+    pub fn total_brns(&self) -> usize { self.brns.iter().sum() }
+
+    /// Return the total number of mispredictions.
+    pub fn total_miss(&self) -> usize { self.miss.iter().sum() }
+
+    /// Return the number of mispredictions per 1000 branches in some window.
+    pub fn mpkb(&self, idx: usize) -> f64 {
+        self.miss[idx] as f64 * 1000.0 / self.brns[idx] as f64
+    }
+
+    /// Return the number of mispredictions per 1000 branches over the
+    /// entire series.
+    pub fn avg_mpkb(&self) -> f64 {
+        self.total_miss() as f64 * 1000.0 / self.total_brns() as f64
+    }
+
+    /// Return an iterator over the MPKB for each window.
+    pub fn iter_mpkb(&self) -> impl Iterator<Item = f64> + '_ {
+        (0..self.len()).map(|idx| self.mpkb(idx))
+    }
+}
+
+impl Merge for WindowSeries {
+    /// Append the windows from 'other' to this series.
+    fn merge(&mut self, other: &Self) {
+        assert!(self.window == other.window);
+        self.brns.extend_from_slice(&other.brns);
+        self.miss.extend_from_slice(&other.miss);
+    }
+}
+
+impl Codec for WindowSeries {
+    fn encode(&self, e: &mut Encoder) {
+        e.put_usize(self.window);
+        e.put_slice(&self.brns);
+        e.put_slice(&self.miss);
+    }
+
+    fn decode(d: &mut Decoder) -> Option<Self> {
+        let window = d.get_usize()?;
+        let brns: Vec<usize> = d.get_vec()?;
+        let miss: Vec<usize> = d.get_vec()?;
+        if window == 0 || brns.len() != miss.len() {
+            return None;
+        }
+        Some(Self { window, brns, miss })
+    }
+}
+
+/// Records a set of named counters over fixed-size windows of conditional 
+/// branches. 
+///
+/// Mispredictions are always tracked (see [WindowRecorder::series]). 
+/// Other metrics are user-defined: call [WindowRecorder::add] for each event,
+/// and [WindowRecorder::step] once per conditional branch. 
+///
+/// When an output file is attached, each completed window is appended to 
+/// the file while the evaluation is running (see [WindowTable] for the 
+/// format).
+pub struct WindowRecorder {
+    /// Series of mispredictions per window
+    series: WindowSeries,
+
+    /// Names of the user-defined metrics
+    names: Vec<String>,
+
+    /// Counters for the user-defined metrics in the current window
+    cur: Vec<u64>,
+
+    /// Optional output file
+    out: Option<BufWriter<File>>,
+}
+impl WindowRecorder {
+    pub fn new(window: usize, names: &[&str]) -> Self {
+        Self {
+            series: WindowSeries::new(window),
+            names: names.iter().map(|s| s.to_string()).collect(),
+            cur: vec![0; names.len()],
+            out: None,
+        }
+    }
+
+    /// Stream each completed window into a file.
+    pub fn with_output(mut self, path: &str) -> std::io::Result<Self> {
+        let mut out = BufWriter::new(File::create(path)?);
+        let mut e = Encoder::new();
+        e.put_raw(WindowTable::MAGIC);
+        e.put_usize(self.series.window);
+        e.put_usize(self.names.len() + 2);
+        e.put_str("brns");
+        e.put_str("miss");
+        for name in self.names.iter() {
+            e.put_str(name);
+        }
+        out.write_all(e.as_bytes())?;
+        self.out = Some(out);
+        Ok(self)
+    }
+
+    /// Return the index of a user-defined metric.
+    pub fn metric(&self, name: &str) -> Option<usize> {
+        self.names.iter().position(|n| n == name)
+    }
+
+    /// Return the series of mispredictions.
+    pub fn series(&self) -> &WindowSeries { &self.series }
+
+    /// Add to some user-defined metric in the current window.
+    pub fn add(&mut self, metric: usize, val: u64) {
+        self.cur[metric] += val;
+    }
+
+    /// Record the result of a prediction. 
+    /// This closes the current window when it becomes full.
+    pub fn step(&mut self, hit: bool) {
+        self.series.record(hit);
+        if *self.series.brns.last().unwrap() == self.series.window {
+            self.flush_window();
+        }
+    }
+
+    /// Write the current window to the output file and reset the counters.
+    fn flush_window(&mut self) {
+        let idx = self.series.len() - 1;
+        if let Some(out) = self.out.as_mut() {
+            let mut e = Encoder::new();
+            e.put_usize(self.series.brns[idx]);
+            e.put_usize(self.series.miss[idx]);
+            for val in self.cur.iter() {
+                e.put_varint(*val);
+            }
+            out.write_all(e.as_bytes()).unwrap();
+        }
+        self.cur.iter_mut().for_each(|x| *x = 0);
+    }
+
+    /// Write any partially-filled window and flush the output file.
+    /// Returns the series of mispredictions.
+    pub fn finish(mut self) -> std::io::Result<WindowSeries> {
+        let partial = match self.series.brns.last() {
+            Some(n) => *n != 0 && *n < self.series.window,
+            None => false,
+        };
+        if partial {
+            self.flush_window();
+        }
+        if let Some(out) = self.out.as_mut() {
+            out.flush()?;
+        }
+        Ok(self.series)
+    }
+}
+
+/// NOTE: Windows already written to an output file are not part of the
+/// saved state, so a recorder with an output file cannot be restored. 
+impl SaveState for WindowRecorder {
+    fn save_state(&self, e: &mut Encoder) {
+        self.series.encode(e);
+        e.put_slice(&self.cur);
+    }
+
+    fn restore_state(&mut self, d: &mut Decoder) -> Option<()> {
+        if self.out.is_some() {
+            return None;
+        }
+        let series = WindowSeries::decode(d)?;
+        let cur: Vec<u64> = d.get_vec()?;
+        if series.window != self.series.window || cur.len() != self.cur.len() {
+            return None;
+        }
+        self.series = series;
+        self.cur = cur;
+        Some(())
+    }
+}
+
+/// A time series of per-window metrics read from a file written by some 
+/// [WindowRecorder]. 
+///
+/// The file consists of a header (magic bytes, window size, and a list of 
+/// column names), followed by one row of varints for each window. The first
+/// two columns are always the number of branches and mispredictions. 
+#[derive(Clone, Debug, PartialEq, Eq)]
+pub struct WindowTable {
+    /// Number of branches in each window
+    pub window: usize,
+
+    /// Column names
+    pub names: Vec<String>,
+
+    /// Values for each window
+    pub rows: Vec<Vec<u64>>,
+}
+impl WindowTable {
+    pub const MAGIC: &'static [u8] = b"DWIN";
+
+    /// Read a table from a file.
+    pub fn from_file(path: &str) -> std::io::Result<Self> {
+        let mut buf = Vec::new();
+        File::open(path)?.read_to_end(&mut buf)?;
+        Self::from_bytes(&buf).ok_or(std::io::Error::new(
+            std::io::ErrorKind::InvalidData, "malformed window series"
+        ))
+    }
+
+    pub fn from_bytes(buf: &[u8]) -> Option<Self> {
+        let mut d = Decoder::new(buf);
+        if d.get_raw(Self::MAGIC.len())? != Self::MAGIC {
+            return None;
+        }
+        let window = d.get_usize()?;
+        let num_cols = d.get_usize()?;
+        let mut names = Vec::new();
+        for _ in 0..num_cols {
+            names.push(d.get_str()?);
+        }
+        let mut rows = Vec::new();
+        while !d.is_empty() {
+            let mut row = Vec::with_capacity(num_cols);
+            for _ in 0..num_cols {
+                row.push(d.get_varint()?);
+            }
+            rows.push(row);
+        }
+        Some(Self { window, names, rows })
+    }
+
+    /// Return the index of a column.
+    pub fn column(&self, name: &str) -> Option<usize> {
+        self.names.iter().position(|n| n == name)
+    }
+
+    /// Return an iterator over the values in some column.
+    pub fn iter_column(&self, idx: usize) -> impl Iterator<Item = u64> + '_ {
+        self.rows.iter().map(move |r| r[idx])
+    }
+
+    /// Convert the first two columns into a [WindowSeries].
+    pub fn to_series(&self) -> WindowSeries {
+        let mut res = WindowSeries::new(self.window);
+        for row in self.rows.iter() {
+            res.push(row[0] as usize, row[1] as usize);
+        }
+        res
+    }
+}
+
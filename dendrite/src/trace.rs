@@ -1,10 +1,16 @@
 
 pub mod assembler;
+pub mod cache;
+pub mod reader;
+
+pub use cache::*;
+pub use reader::*;
 
 use std::fs::File;
 use std::io::Read;
 use std::path::Path;
 use crate::branch::*;
+use crate::hugepage::*;
 
 pub struct BinaryTraceSet {
     /// A list of filenames
@@ -66,18 +72,27 @@ impl BinaryTrace {
     /// Create a [BinaryTrace] from a file.
     /// NOTE: We aren't validating input at all
     pub fn from_file(path: &str, name: &str) -> Self {
-        let mut f = File::open(path).unwrap();
-        let len = std::fs::metadata(path).unwrap().len() as usize;
-        assert!(len % std::mem::size_of::<BranchRecord>() == 0);
+        Self::open(path, name).unwrap()
+    }
+
+    /// Create a [BinaryTrace] from a file, returning an error if the file 
+    /// can't be read or isn't a whole number of records. 
+    pub fn open(path: &str, name: &str) -> std::io::Result<Self> {
+        let mut f = File::open(path)?;
+        let len = f.metadata()?.len() as usize;
+        if len % std::mem::size_of::<BranchRecord>() != 0 {
+            return Err(std::io::Error::new(std::io::ErrorKind::InvalidData,
+                format!("{}: not a whole number of records", path)));
+        }
 
         let num_entries = len / std::mem::size_of::<BranchRecord>();
-        let mut data = vec![0; len];
-        f.read(&mut data).unwrap();
-        Self { 
+        let mut data = huge_vec(len, 0);
+        f.read_exact(&mut data)?;
+        Ok(Self { 
             data, 
             num_entries,
             name: name.to_string(),
-        }
+        })
     }
 
     /// Return the number of records
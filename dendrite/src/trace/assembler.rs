@@ -330,4 +330,34 @@ impl TraceAssembler {
     }
 }
 
+/// Build a synthetic trace with 'len' records from a loop with periodic 
+/// and fixed-pattern branches.
+///
+/// This is the shared input for the kernel benchmarks and the golden 
+/// results checked by 'regress', so changing it changes both.
+pub fn synthetic_loop(len: usize) -> SyntheticTrace {
+    static PAT: [Outcome; 7] = [
+        Outcome::T, Outcome::N, Outcome::N, Outcome::T, 
+        Outcome::T, Outcome::T, Outcome::N,
+    ];
+    let mut asm = TraceAssembler::new(0x0040_0000);
+    let top = asm.create_label();
+    let skip0 = asm.create_label();
+    let skip1 = asm.create_label();
+    let skip2 = asm.create_label();
+
+    asm.bind_label(top);
+    asm.branch_to_label(skip0, BranchPattern::TakenPeriodic(3));
+    asm.pad(0x20);
+    asm.bind_label(skip0);
+    asm.branch_to_label(skip1, BranchPattern::NotTakenPeriodic(5));
+    asm.pad(0x40);
+    asm.bind_label(skip1);
+    asm.branch_to_label(skip2, BranchPattern::Pattern(&PAT));
+    asm.pad(0x10);
+    asm.bind_label(skip2);
+    asm.branch_to_label(top, BranchPattern::TakenPeriodic(17));
+    asm.jump_to_label(top);
+    asm.compile(len)
+}
 
@@ -0,0 +1,160 @@
+
+use std::collections::*;
+use std::path::Path;
+use std::sync::{ Arc, Condvar, Mutex };
+use crate::trace::*;
+
+/// The state of a trace in a [TraceCache].
+enum CacheEntry {
+    /// Some thread is currently reading the trace from disk
+    Loading,
+
+    /// The trace is resident, along with the number of outstanding handles
+    Resident(Arc<BinaryTrace>, usize),
+}
+
+struct CacheState {
+    entries: HashMap<String, CacheEntry>,
+
+    /// Number of bytes used by resident and loading traces
+    resident_bytes: usize,
+}
+
+/// Shares loaded traces between threads, while bounding the total size of
+/// resident traces.
+///
+/// A trace is loaded on the first request and shared by any requests made
+/// while it is resident. Traces stay resident after the last [TraceHandle]
+/// is dropped, and are only freed when some other trace needs the space.
+/// When loading a trace would exceed the limit, the requesting thread waits
+/// until enough memory can be freed.
+///
+/// NOTE: A trace larger than the limit is only loaded when no other traces
+/// are resident.
+pub struct TraceCache {
+    state: Mutex<CacheState>,
+    cond: Condvar,
+
+    /// Maximum number of bytes used by resident traces
+    limit: usize,
+}
+impl TraceCache {
+    pub fn new(limit: usize) -> Self {
+        Self {
+            state: Mutex::new(CacheState {
+                entries: HashMap::new(),
+                resident_bytes: 0,
+            }),
+            cond: Condvar::new(),
+            limit,
+        }
+    }
+
+    /// Return the number of bytes used by resident traces.
+    pub fn resident_bytes(&self) -> usize {
+        self.state.lock().unwrap().resident_bytes
+    }
+
+    /// Get a handle to some trace, loading it if necessary.
+    ///
+    /// If the trace can't be read, the reservation is released [so other
+    /// threads waiting for the same trace try to load it themselves] and 
+    /// the error is returned.
+    pub fn get(&self, path: &str) -> std::io::Result<TraceHandle<'_>> {
+        let size = std::fs::metadata(path)?.len() as usize;
+        let mut state = self.state.lock().unwrap();
+        loop {
+            match state.entries.get_mut(path) {
+                Some(CacheEntry::Resident(trace, refs)) => {
+                    *refs += 1;
+                    return Ok(TraceHandle {
+                        cache: self,
+                        path: path.to_string(),
+                        trace: trace.clone(),
+                    });
+                },
+                Some(CacheEntry::Loading) => {},
+                None => {
+                    if state.resident_bytes + size > self.limit {
+                        Self::evict_unused(&mut state);
+                    }
+                    let fits = state.resident_bytes + size <= self.limit;
+                    if fits || state.resident_bytes == 0 {
+                        break;
+                    }
+                },
+            }
+            state = self.cond.wait(state).unwrap();
+        }
+
+        // Reserve memory for this trace and load it without holding the lock
+        state.entries.insert(path.to_string(), CacheEntry::Loading);
+        state.resident_bytes += size;
+        drop(state);
+
+        let name = Path::new(path).file_name()
+            .and_then(|s| s.to_str())
+            .unwrap_or(path);
+        let res = BinaryTrace::open(path, name);
+
+        let mut state = self.state.lock().unwrap();
+        let trace = match res {
+            Ok(trace) => Arc::new(trace),
+            Err(e) => {
+                state.entries.remove(path);
+                state.resident_bytes -= size;
+                self.cond.notify_all();
+                return Err(e);
+            },
+        };
+        state.entries.insert(path.to_string(),
+            CacheEntry::Resident(trace.clone(), 1)
+        );
+        self.cond.notify_all();
+        Ok(TraceHandle { cache: self, path: path.to_string(), trace })
+    }
+
+    /// Free all resident traces without any outstanding handles.
+    fn evict_unused(state: &mut CacheState) {
+        let mut freed = 0;
+        state.entries.retain(|_, entry| match entry {
+            CacheEntry::Resident(trace, 0) => {
+                freed += trace.data.len();
+                false
+            },
+            _ => true,
+        });
+        state.resident_bytes -= freed;
+    }
+
+    /// Release a reference to some trace.
+    fn release(&self, path: &str) {
+        let mut state = self.state.lock().unwrap();
+        match state.entries.get_mut(path) {
+            Some(CacheEntry::Resident(_, refs)) => {
+                *refs -= 1;
+                if *refs == 0 {
+                    self.cond.notify_all();
+                }
+            },
+            _ => unreachable!(),
+        }
+    }
+}
+
+/// A reference to some trace in a [TraceCache].
+pub struct TraceHandle<'a> {
+    cache: &'a TraceCache,
+    path: String,
+    trace: Arc<BinaryTrace>,
+}
+impl <'a> std::ops::Deref for TraceHandle<'a> {
+    type Target = BinaryTrace;
+    fn deref(&self) -> &BinaryTrace { &self.trace }
+}
+impl <'a> Drop for TraceHandle<'a> {
+    fn drop(&mut self) {
+        self.cache.release(&self.path);
+    }
+}
+
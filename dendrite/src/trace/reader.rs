@@ -0,0 +1,91 @@
+
+use std::fs::File;
+use std::io::Read;
+use crate::branch::*;
+
+/// Reads and validates records from a trace file in blocks, without 
+/// loading the whole file into memory.
+///
+/// Unlike [BinaryTrace], each record is decoded field-by-field and checked 
+/// for a valid [Outcome] and [BranchKind]. Invalid records are skipped and
+/// counted.
+pub struct TraceReader {
+    inp: File,
+    buf: Vec<u8>,
+
+    /// Number of records read from the file
+    pub num_records: usize,
+
+    /// Number of records skipped because they were invalid
+    pub num_invalid: usize,
+}
+impl TraceReader {
+    /// Size of a record in the trace file [in bytes]
+    pub const RECORD_SIZE: usize = std::mem::size_of::<BranchRecord>();
+
+    pub fn open(path: &str) -> std::io::Result<Self> {
+        Ok(Self {
+            inp: File::open(path)?,
+            buf: Vec::new(),
+            num_records: 0,
+            num_invalid: 0,
+        })
+    }
+
+    /// Decode a single record.
+    /// Returns [None] if the record is invalid.
+    pub fn decode(bytes: &[u8]) -> Option<BranchRecord> {
+        let word = |off: usize| {
+            u64::from_le_bytes(bytes[off..off+8].try_into().unwrap())
+        };
+        let half = |off: usize| {
+            u32::from_le_bytes(bytes[off..off+4].try_into().unwrap())
+        };
+        let kind = BranchKind::from_u32(half(20))?;
+        if kind == BranchKind::Invalid {
+            return None;
+        }
+        Some(BranchRecord {
+            pc: word(0) as usize,
+            tgt: word(8) as usize,
+            outcome: Outcome::from_u32(half(16))?,
+            kind,
+        })
+    }
+
+    /// Read up to 'max' records from the file, replacing the contents of 
+    /// 'out' with the valid records. 
+    ///
+    /// Returns the number of records read from the file [including invalid
+    /// records], or zero at the end of the file. 
+    pub fn read_block(&mut self, out: &mut Vec<BranchRecord>, max: usize)
+        -> std::io::Result<usize>
+    {
+        out.clear();
+        self.buf.resize(max * Self::RECORD_SIZE, 0);
+
+        // Fill the buffer unless we reach the end of the file
+        let mut len = 0;
+        while len < self.buf.len() {
+            match self.inp.read(&mut self.buf[len..])? {
+                0 => break,
+                n => len += n,
+            }
+        }
+        if len % Self::RECORD_SIZE != 0 {
+            return Err(std::io::Error::new(std::io::ErrorKind::InvalidData,
+                "trace ends with a partial record"));
+        }
+
+        let num_read = len / Self::RECORD_SIZE;
+        for bytes in self.buf[..len].chunks_exact(Self::RECORD_SIZE) {
+            match Self::decode(bytes) {
+                Some(record) => out.push(record),
+                None => self.num_invalid += 1,
+            }
+        }
+        self.num_records += num_read;
+        Ok(num_read)
+    }
+}
+